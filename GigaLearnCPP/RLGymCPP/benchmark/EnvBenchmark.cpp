@@ -0,0 +1,283 @@
+// Headless env throughput benchmark
+// Steps an EnvSet with random valid actions and reports steps/second and per-phase times for each thread count as JSON
+// Doesn't need libtorch, so it can be built on its own from the RLGymCPP folder with -DRLGC_BUILD_ENV_BENCHMARK=ON
+//
+// Example:
+//	RLGymCPPEnvBenchmark --meshes collision_meshes --arenas 256 --team-size 1 --obs advanced --rewards common --threads 1,2,4,8 --out bench.json
+
+#include <RLGymCPP/EnvSet/EnvSet.h>
+#include <RLGymCPP/ActionParsers/DefaultAction.h>
+#include <RLGymCPP/ObsBuilders/DefaultObs.h>
+#include <RLGymCPP/ObsBuilders/DefaultObsPadded.h>
+#include <RLGymCPP/ObsBuilders/AdvancedObs.h>
+#include <RLGymCPP/Rewards/CommonRewards.h>
+#include <RLGymCPP/Rewards/ZeroSumReward.h>
+#include <RLGymCPP/StateSetters/KickoffState.h>
+#include <RLGymCPP/TerminalConditions/GoalScoreCondition.h>
+#include <RLGymCPP/TerminalConditions/NoTouchCondition.h>
+
+#include <random>
+#include <iomanip>
+
+using namespace RLGC;
+
+struct BenchmarkConfig {
+	std::filesystem::path meshesFolder = "collision_meshes";
+
+	int numArenas = 256;
+	int teamSize = 1;
+	std::string obsBuilder = "default"; // "default", "padded" or "advanced"
+	std::string rewards = "common"; // "none", "goal" or "common"
+	int tickSkip = 8;
+	int actionDelay = 7;
+	int numShards = 1;
+
+	int warmupSteps = 50;
+	int steps = 500;
+	std::vector<int> threadCounts = {}; // Empty to just use the default thread count
+
+	std::filesystem::path outputPath = {}; // Empty to only print
+};
+
+// Times for one thread count, in seconds
+struct BenchmarkResult {
+	int numThreads;
+	double totalTime;
+	double resetTime, firstHalfTime, secondHalfTime, actionTime;
+};
+
+static void PrintUsage() {
+	RG_LOG(
+		"Usage: RLGymCPPEnvBenchmark [options]\n"
+		"  --meshes <path>         Collision meshes folder (default: collision_meshes)\n"
+		"  --arenas <n>            Number of arenas (default: 256)\n"
+		"  --team-size <n>         Cars per team (default: 1)\n"
+		"  --obs <name>            default, padded or advanced (default: default)\n"
+		"  --rewards <name>        none, goal or common (default: common)\n"
+		"  --tick-skip <n>         Tick skip (default: 8), action delay is tick skip - 1\n"
+		"  --shards <n>            Env shards (default: 1)\n"
+		"  --warmup <n>            Steps before timing (default: 50)\n"
+		"  --steps <n>             Timed steps per thread count (default: 500)\n"
+		"  --threads <a,b,...>     Thread counts to test (default: hardware thread count)\n"
+		"  --out <path>            Also write the JSON results to this file"
+	);
+}
+
+static BenchmarkConfig ParseArgs(int argc, char* argv[]) {
+	BenchmarkConfig config = {};
+
+	for (int i = 1; i < argc; i++) {
+		std::string arg = argv[i];
+		if (arg == "--help" || arg == "-h") {
+			PrintUsage();
+			exit(EXIT_SUCCESS);
+		}
+
+		if (i + 1 >= argc)
+			RG_ERR_CLOSE("Missing value for argument \"" << arg << "\"");
+		std::string val = argv[++i];
+
+		if (arg == "--meshes") {
+			config.meshesFolder = val;
+		} else if (arg == "--arenas") {
+			config.numArenas = std::stoi(val);
+		} else if (arg == "--team-size") {
+			config.teamSize = std::stoi(val);
+		} else if (arg == "--obs") {
+			config.obsBuilder = val;
+		} else if (arg == "--rewards") {
+			config.rewards = val;
+		} else if (arg == "--tick-skip") {
+			config.tickSkip = std::stoi(val);
+			config.actionDelay = config.tickSkip - 1;
+		} else if (arg == "--shards") {
+			config.numShards = std::stoi(val);
+		} else if (arg == "--warmup") {
+			config.warmupSteps = std::stoi(val);
+		} else if (arg == "--steps") {
+			config.steps = std::stoi(val);
+		} else if (arg == "--threads") {
+			std::stringstream stream(val);
+			std::string count;
+			while (std::getline(stream, count, ','))
+				config.threadCounts.push_back(std::stoi(count));
+		} else if (arg == "--out") {
+			config.outputPath = val;
+		} else {
+			PrintUsage();
+			RG_ERR_CLOSE("Unknown argument \"" << arg << "\"");
+		}
+	}
+
+	if (config.numArenas < 1 || config.teamSize < 1 || config.tickSkip < 1 || config.steps < 1)
+		RG_ERR_CLOSE("Arena count, team size, tick skip and steps must all be at least 1");
+
+	if (config.threadCounts.empty())
+		config.threadCounts.push_back(g_ThreadPool.GetNumThreads());
+
+	return config;
+}
+
+static EnvCreateFn MakeEnvCreateFn(const BenchmarkConfig& config) {
+	return [config](int index) {
+		EnvCreateResult result = {};
+
+		result.arena = Arena::Create(GameMode::SOCCAR);
+		for (int i = 0; i < config.teamSize; i++) {
+			result.arena->AddCar(Team::BLUE);
+			result.arena->AddCar(Team::ORANGE);
+		}
+
+		if (config.obsBuilder == "default") {
+			result.obsBuilder = new DefaultObs();
+		} else if (config.obsBuilder == "padded") {
+			result.obsBuilder = new DefaultObsPadded(config.teamSize);
+		} else if (config.obsBuilder == "advanced") {
+			result.obsBuilder = new AdvancedObs();
+		} else {
+			RG_ERR_CLOSE("Unknown obs builder \"" << config.obsBuilder << "\"");
+		}
+
+		// A typical mix of cheap and event-based rewards
+		if (config.rewards == "goal") {
+			result.rewards = { { new GoalReward(), 1 } };
+		} else if (config.rewards == "common") {
+			result.rewards = {
+				{ new AirReward(), 0.25f },
+				{ new FaceBallReward(), 0.25f },
+				{ new VelocityPlayerToBallReward(), 4.f },
+				{ new StrongTouchReward(20, 100), 60 },
+				{ new ZeroSumReward(new VelocityBallToGoalReward(), 1), 2.0f },
+				{ new PickupBoostReward(), 10.f },
+				{ new SaveBoostReward(), 0.2f },
+				{ new ZeroSumReward(new BumpReward(), 0.5f), 20 },
+				{ new ZeroSumReward(new DemoReward(), 0.5f), 80 },
+				{ new GoalReward(), 150 }
+			};
+		} else if (config.rewards != "none") {
+			RG_ERR_CLOSE("Unknown reward set \"" << config.rewards << "\"");
+		}
+
+		result.terminalConditions = { new NoTouchCondition(10), new GoalScoreCondition() };
+		result.actionParser = new DefaultAction();
+		result.stateSetter = new KickoffState();
+
+		return result;
+	};
+}
+
+static BenchmarkResult RunBenchmark(EnvSet& envSet, const BenchmarkConfig& config, int numThreads) {
+	g_ThreadPool.Resize(numThreads);
+
+	BenchmarkResult result = {};
+	result.numThreads = numThreads;
+
+	std::mt19937 rng(0);
+	int numPlayers = envSet.state.numPlayers;
+	int numActions = envSet.state.actionMasks.size[1];
+
+	for (int step = 0; step < config.warmupSteps + config.steps; step++) {
+		bool timed = step >= config.warmupSteps;
+		auto fnTime = [timed](double& total, auto fn) {
+			auto start = std::chrono::steady_clock::now();
+			fn();
+			if (timed)
+				total += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		};
+
+		fnTime(result.resetTime, [&]() { envSet.Reset(); });
+
+		// Random valid action for each player, same as a policy would pick from the masks
+		fnTime(result.actionTime, [&]() {
+			for (int i = 0; i < numPlayers; i++) {
+				int action;
+				do {
+					action = std::uniform_int_distribution<int>(0, numActions - 1)(rng);
+				} while (!envSet.state.actionMasks.At(i, action));
+				envSet.state.actions[i] = action;
+			}
+		});
+
+		fnTime(result.firstHalfTime, [&]() { envSet.StepFirstHalf(false); });
+		fnTime(result.secondHalfTime, [&]() {
+			for (int shardIdx = 0; shardIdx < envSet.shards.size(); shardIdx++)
+				envSet.StepShardSecondHalf(shardIdx, envSet.state.actions, true);
+			envSet.Sync();
+		});
+	}
+
+	result.totalTime = result.resetTime + result.actionTime + result.firstHalfTime + result.secondHalfTime;
+	return result;
+}
+
+int main(int argc, char* argv[]) {
+	BenchmarkConfig config = ParseArgs(argc, argv);
+
+	RocketSim::Init(config.meshesFolder, true);
+
+	EnvSetConfig envSetConfig = {};
+	envSetConfig.envCreateFn = MakeEnvCreateFn(config);
+	envSetConfig.numArenas = config.numArenas;
+	envSetConfig.tickSkip = config.tickSkip;
+	envSetConfig.actionDelay = config.actionDelay;
+	envSetConfig.saveRewards = false;
+	envSetConfig.numShards = config.numShards;
+
+	RG_LOG("Creating " << config.numArenas << " arenas...");
+	EnvSet envSet(envSetConfig);
+	int numPlayers = envSet.state.numPlayers;
+	RG_LOG(" > Obs size: " << envSet.obsSize << ", players: " << numPlayers);
+
+	std::vector<BenchmarkResult> results = {};
+	for (int numThreads : config.threadCounts) {
+		RG_LOG("Benchmarking with " << numThreads << " thread(s)...");
+		BenchmarkResult result = RunBenchmark(envSet, config, numThreads);
+		RG_LOG(" > " << (int)(config.steps * numPlayers / result.totalTime) << " player steps/second");
+		results.push_back(result);
+	}
+
+	std::stringstream json;
+	json << std::fixed << std::setprecision(6);
+	json << "{\n";
+	json << "\t\"config\": {"
+		<< "\"arenas\": " << config.numArenas << ", "
+		<< "\"team_size\": " << config.teamSize << ", "
+		<< "\"players\": " << numPlayers << ", "
+		<< "\"obs_builder\": \"" << config.obsBuilder << "\", "
+		<< "\"obs_size\": " << envSet.obsSize << ", "
+		<< "\"rewards\": \"" << config.rewards << "\", "
+		<< "\"tick_skip\": " << config.tickSkip << ", "
+		<< "\"shards\": " << config.numShards << ", "
+		<< "\"steps\": " << config.steps
+		<< "},\n";
+	json << "\t\"results\": [\n";
+	for (int i = 0; i < results.size(); i++) {
+		auto& result = results[i];
+		double baseTime = results[0].totalTime * results[0].numThreads;
+		json << "\t\t{"
+			<< "\"threads\": " << result.numThreads << ", "
+			<< "\"env_steps_per_second\": " << (config.steps * config.numArenas / result.totalTime) << ", "
+			<< "\"player_steps_per_second\": " << (config.steps * numPlayers / result.totalTime) << ", "
+			<< "\"ticks_per_second\": " << ((double)config.steps * config.numArenas * config.tickSkip / result.totalTime) << ", "
+			<< "\"total_time\": " << result.totalTime << ", "
+			<< "\"reset_time\": " << result.resetTime << ", "
+			<< "\"action_time\": " << result.actionTime << ", "
+			<< "\"first_half_time\": " << result.firstHalfTime << ", "
+			<< "\"second_half_time\": " << result.secondHalfTime << ", "
+			<< "\"parallel_efficiency\": " << (baseTime / (result.totalTime * result.numThreads)) // Relative to the first thread count
+			<< "}" << ((i + 1 < results.size()) ? "," : "") << "\n";
+	}
+	json << "\t]\n}\n";
+
+	std::cout << json.str();
+
+	if (!config.outputPath.empty()) {
+		std::ofstream fOut(config.outputPath);
+		if (!fOut.good())
+			RG_ERR_CLOSE("Failed to open output file " << config.outputPath);
+		fOut << json.str();
+		RG_LOG("Wrote results to " << config.outputPath);
+	}
+
+	return EXIT_SUCCESS;
+}
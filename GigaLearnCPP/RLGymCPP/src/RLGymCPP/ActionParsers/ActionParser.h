@@ -16,5 +16,11 @@ namespace RLGC {
 		virtual std::vector<uint8_t> GetActionMask(const Player& player, const GameState& state) {
 			return std::vector<uint8_t>(GetActionAmount(), true);
 		}
+
+		// Returns the index of the X-mirrored version of each action (steer, yaw, and roll negated)
+		// Needed for mirror augmentation, empty if not supported
+		virtual std::vector<int> GetMirrorMap() {
+			return {};
+		}
 	};
 }
\ No newline at end of file
@@ -116,3 +116,24 @@ std::vector<uint8_t> RLGC::DefaultAction::GetActionMask(const Player& player, co
 
 	return result;
 }
+
+std::vector<int> RLGC::DefaultAction::GetMirrorMap() {
+	std::vector<int> result(actions.size(), -1);
+	for (int i = 0; i < actions.size(); i++) {
+		Action mirrored = actions[i];
+		mirrored.steer *= -1;
+		mirrored.yaw *= -1;
+		mirrored.roll *= -1;
+
+		for (int j = 0; j < actions.size(); j++) {
+			if (std::equal(mirrored.begin(), mirrored.end(), actions[j].begin())) {
+				result[i] = j;
+				break;
+			}
+		}
+
+		if (result[i] == -1)
+			RG_ERR_CLOSE("DefaultAction::GetMirrorMap(): No mirrored version of action " << actions[i]);
+	}
+	return result;
+}
@@ -21,5 +21,7 @@ namespace RLGC {
 		}
 
 		virtual std::vector<uint8_t> GetActionMask(const Player& player, const GameState& state) override;
+
+		virtual std::vector<int> GetMirrorMap() override;
 	};
 }
\ No newline at end of file
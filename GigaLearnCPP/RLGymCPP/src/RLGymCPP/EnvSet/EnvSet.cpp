@@ -1,5 +1,8 @@
 #include "EnvSet.h"
 #include  "../Rewards/ZeroSumReward.h"
+#include "../Tracer.h"
+#include "../Math.h"
+#include "../Gamestates/StateUtil.h"
 #include <algorithm>
 
 template<bool RLGC::PlayerEventState::* DATA_VAR>
@@ -108,52 +111,76 @@ RLGC::EnvSet::EnvSet(const EnvSetConfig& config) : config(config) {
 	RG_ASSERT(config.tickSkip > 0);
 	RG_ASSERT(config.actionDelay >= 0 && config.actionDelay <= config.tickSkip);
 
-	std::mutex appendMutex = {};
+	for (int i = 0; i < config.numArenas; i++)
+		arenaRNGs.push_back(PhiloxRNG(config.randomSeed, i));
+
+	// Everything is stored by arena index rather than creation order, so arenas line up with their RNG streams
+	arenas.resize(config.numArenas);
+	eventTrackers.resize(config.numArenas);
+	eventCallbackInfos.resize(config.numArenas);
+	userInfos.resize(config.numArenas);
+	rewards.resize(config.numArenas);
+	terminalConditions.resize(config.numArenas);
+	obsBuilders.resize(config.numArenas);
+	actionParsers.resize(config.numArenas);
+	stateSetters.resize(config.numArenas);
+
 	auto fnCreateArenas = [&](int idx) {
+		ArenaRNGScope rngScope(&arenaRNGs[idx]);
 		auto createResult = config.envCreateFn(idx);
 		auto arena = createResult.arena;
 
-		appendMutex.lock();
-		{
-			arenas.push_back(arena);
-
-			auto userInfo = new CallbackUserInfo();
-			userInfo->arena = arena;
-			userInfo->arenaIdx = idx;
-			userInfo->envSet = this;
-			eventCallbackInfos.push_back(userInfo);
-			arena->SetCarBumpCallback(_BumpCallback, userInfo);
-
-			if (arena->gameMode != GameMode::HEATSEEKER) {
-				GameEventTracker* tracker = new GameEventTracker({});
-				eventTrackers.push_back(tracker);
-
-				tracker->SetShotCallback(_ShotEventCallback, userInfo);
-				tracker->SetGoalCallback(_GoalEventCallback, userInfo);
-				tracker->SetSaveCallback(_SaveEventCallback, userInfo);
-			} else {
-				eventTrackers.push_back(NULL);
-				eventCallbackInfos.push_back(NULL);
-			}
+		arenas[idx] = arena;
 
-			userInfos.push_back(createResult.userInfo);
+		auto userInfo = new CallbackUserInfo();
+		userInfo->arena = arena;
+		userInfo->arenaIdx = idx;
+		userInfo->envSet = this;
+		eventCallbackInfos[idx] = userInfo;
+		arena->SetCarBumpCallback(_BumpCallback, userInfo);
 
-			rewards.push_back(createResult.rewards);
-			terminalConditions.push_back(createResult.terminalConditions);
-			obsBuilders.push_back(createResult.obsBuilder);
-			actionParsers.push_back(createResult.actionParser);
-			stateSetters.push_back(createResult.stateSetter);
+		if (arena->gameMode != GameMode::HEATSEEKER) {
+			GameEventTracker* tracker = new GameEventTracker({});
+			eventTrackers[idx] = tracker;
+
+			tracker->SetShotCallback(_ShotEventCallback, userInfo);
+			tracker->SetGoalCallback(_GoalEventCallback, userInfo);
+			tracker->SetSaveCallback(_SaveEventCallback, userInfo);
+		} else {
+			eventTrackers[idx] = NULL;
 		}
-		appendMutex.unlock();
+
+		userInfos[idx] = createResult.userInfo;
+
+		rewards[idx] = createResult.rewards;
+		terminalConditions[idx] = createResult.terminalConditions;
+		obsBuilders[idx] = createResult.obsBuilder;
+		actionParsers[idx] = createResult.actionParser;
+		stateSetters[idx] = createResult.stateSetter;
 	};
 	g_ThreadPool.StartBatchedJobs(fnCreateArenas, config.numArenas, false);
 
 	state.Resize(arenas);
 	scenarioCache.resize(arenas.size());
+
+	// Split arenas into shards
+	{
+		int numShards = RS_CLAMP(config.numShards, 1, (int)arenas.size());
+		for (int i = 0; i < numShards; i++) {
+			EnvShard shard = {};
+			shard.arenaStart = (arenas.size() * i) / numShards;
+			shard.arenaEnd = (arenas.size() * (i + 1)) / numShards;
+			shard.playerStart = state.arenaPlayerStartIdx[shard.arenaStart];
+			shard.playerEnd = (shard.arenaEnd < arenas.size()) ? state.arenaPlayerStartIdx[shard.arenaEnd] : state.numPlayers;
+			shard.firstHalfJobs = new JobCounter();
+			shards.push_back(shard);
+		}
+	}
 	scenarioNames.resize(arenas.size());
 	
 	// Determine obs size and action amount, initialize arrays accordingly
 	{
+		ArenaRNGScope rngScope(&arenaRNGs[0]);
 		stateSetters[0]->ResetArena(arenas[0]);
 		GameState testState = GameState(arenas[0]);
 		testState.userInfo = userInfos[0];
@@ -162,6 +189,15 @@ RLGC::EnvSet::EnvSet(const EnvSetConfig& config) : config(config) {
 		state.obs = DimList2<float>(state.numPlayers, obsSize);
 
 		state.actionMasks = DimList2<uint8_t>(state.numPlayers, actionParsers[0]->GetActionAmount());
+
+		if (config.buildMirroredObs) {
+			actionMirrorMap = actionParsers[0]->GetMirrorMap();
+			if (actionMirrorMap.size() != actionParsers[0]->GetActionAmount())
+				RG_ERR_CLOSE("EnvSet: Mirrored obs require an action parser that supports GetMirrorMap()");
+
+			state.mirrorObs = DimList2<float>(state.numPlayers, obsSize);
+			state.mirrorActionMasks = DimList2<uint8_t>(state.numPlayers, actionParsers[0]->GetActionAmount());
+		}
 	}
 
 	// Reset all arenas initially
@@ -174,149 +210,219 @@ RLGC::EnvSet::EnvSet(const EnvSetConfig& config) : config(config) {
 
 void RLGC::EnvSet::StepFirstHalf(bool async) {
 
+	for (auto& shard : shards)
+		shard.firstHalfJobs->Add(shard.arenaEnd - shard.arenaStart);
+
 	auto fnStepArena = [&](int arenaIdx) {
-		Arena* arena = arenas[arenaIdx];
-		auto& gs = state.gameStates[arenaIdx];
+		RG_TRACE_SCOPE("Arena Step First Half", arenaIdx);
 
-		{
-			// Set previous gamestates
-			state.prevGameStates[arenaIdx] = gs;
+		JobCounter* shardJobs = NULL;
+		for (auto& shard : shards) {
+			if (arenaIdx < shard.arenaEnd) {
+				shardJobs = shard.firstHalfJobs;
+				break;
+			}
 		}
 
-		gs.ResetBeforeStep();
+		// The shard's counter must be marked done even if the step throws, or its second half would wait forever
+		// The exception is passed on too, so it also reaches Sync()
+		try {
+			// Cars demoed during this half respawn at a random location
+			ArenaRNGScope rngScope(&arenaRNGs[arenaIdx]);
+			Arena* arena = arenas[arenaIdx];
+			auto& gs = state.gameStates[arenaIdx];
+
+			{
+				// Set previous gamestates
+				state.prevGameStates[arenaIdx] = gs;
+			}
+
+			gs.ResetBeforeStep();
 
-		// Step arena with old actions
-		arena->Step(config.actionDelay);
+			// Step arena with old actions
+			arena->Step(config.actionDelay);
+		} catch (...) {
+			shardJobs->Done(std::current_exception());
+			throw;
+		}
+		shardJobs->Done();
 	};
 
-	g_ThreadPool.StartBatchedJobs(fnStepArena, arenas.size(), async);
+	g_ThreadPool.StartCountedJobs(fnStepArena, arenas.size(), jobs);
+	if (!async)
+		Sync();
 }
 
 void RLGC::EnvSet::StepSecondHalf(const IList& actionIndices, bool async) {
+	g_ThreadPool.StartCountedJobs(
+		[this, &actionIndices](int arenaIdx) { _StepArenaSecondHalf(arenaIdx, actionIndices); },
+		arenas.size(), jobs
+	);
+	if (!async)
+		Sync();
+}
 
-	auto fnStepArenas = [&](int arenaIdx) {
-
-		Arena* arena = arenas[arenaIdx];
-		auto& gs = state.gameStates[arenaIdx];
-		int playerStartIdx = state.arenaPlayerStartIdx[arenaIdx];
-			
-		// Parse and set actions
-		auto actions = std::vector<Action>(gs.players.size());
-		auto carItr = arena->_cars.begin();
-		for (int i = 0; i < gs.players.size(); i++, carItr++) {
-			auto& player = gs.players[i];
-			Car* car = *carItr;
-			Action action = actionParsers[arenaIdx]->ParseAction(actionIndices[playerStartIdx + i], player, gs);
-			car->controls = (CarControls)action;
-			actions[i] = action;
-		}
+void RLGC::EnvSet::StepShardSecondHalf(int shardIdx, const IList& actionIndices, bool async) {
+	auto& shard = shards[shardIdx];
+	shard.firstHalfJobs->Wait();
+
+	int arenaStart = shard.arenaStart;
+	g_ThreadPool.StartCountedJobs(
+		[this, &actionIndices, arenaStart](int idx) { _StepArenaSecondHalf(arenaStart + idx, actionIndices); },
+		shard.arenaEnd - shard.arenaStart, jobs
+	);
+	if (!async)
+		Sync();
+}
 
-		// Step arena with new actions we got from observing the last state
-		// Update the gamestate after
-		{
-			arena->Step(config.tickSkip - config.actionDelay);
+void RLGC::EnvSet::_StepArenaSecondHalf(int arenaIdx, const IList& actionIndices) {
+	RG_TRACE_SCOPE("Arena Step Second Half", arenaIdx);
+	ArenaRNGScope rngScope(&arenaRNGs[arenaIdx]);
+	Arena* arena = arenas[arenaIdx];
+	auto& gs = state.gameStates[arenaIdx];
+	int playerStartIdx = state.arenaPlayerStartIdx[arenaIdx];
+		
+	// Parse and set actions
+	auto actions = std::vector<Action>(gs.players.size());
+	auto carItr = arena->_cars.begin();
+	for (int i = 0; i < gs.players.size(); i++, carItr++) {
+		auto& player = gs.players[i];
+		Car* car = *carItr;
+		Action action = actionParsers[arenaIdx]->ParseAction(actionIndices[playerStartIdx + i], player, gs);
+		car->controls = (CarControls)action;
+		actions[i] = action;
+	}
 
-			if (eventTrackers[arenaIdx])
-				eventTrackers[arenaIdx]->Update(arena);
+	// Step arena with new actions we got from observing the last state
+	// Update the gamestate after
+	{
+		arena->Step(config.tickSkip - config.actionDelay);
 
-			GameState* gsPrev = &state.prevGameStates[arenaIdx];
-			if (gsPrev->IsEmpty())
-				gsPrev = NULL;
+		if (eventTrackers[arenaIdx])
+			eventTrackers[arenaIdx]->Update(arena);
 
-			gs.UpdateFromArena(arena, actions, gsPrev);
-		}
+		GameState* gsPrev = &state.prevGameStates[arenaIdx];
+		if (gsPrev->IsEmpty())
+			gsPrev = NULL;
 
-		// Update terminal
-		uint8_t terminalType = TerminalType::NOT_TERMINAL;
-		{
-			for (auto cond : terminalConditions[arenaIdx]) {
-				if (cond->IsTerminal(gs)) {
-					bool isTrunc = cond->IsTruncation();
-					uint8_t curTerminalType = isTrunc ? TerminalType::TRUNCATED : TerminalType::NORMAL;
-					if (terminalType == TerminalType::NOT_TERMINAL) {
-						terminalType = curTerminalType;
-					} else {
-						// We already know this state is terminal
-						// However, if we only know it is a truncated terminal, we should let normal terminals take priority
-						// (Normal terminals are better information than truncations)
-						if (curTerminalType == TerminalType::NORMAL)
-							terminalType = curTerminalType;
-					}
+		gs.UpdateFromArena(arena, actions, gsPrev);
+	}
 
-					// NOTE: We can't break since terminal conditions are guaranteed to be called once per step
+	// Update terminal
+	uint8_t terminalType = TerminalType::NOT_TERMINAL;
+	{
+		for (auto cond : terminalConditions[arenaIdx]) {
+			if (cond->IsTerminal(gs)) {
+				bool isTrunc = cond->IsTruncation();
+				uint8_t curTerminalType = isTrunc ? TerminalType::TRUNCATED : TerminalType::NORMAL;
+				if (terminalType == TerminalType::NOT_TERMINAL) {
+					terminalType = curTerminalType;
+				} else {
+					// We already know this state is terminal
+					// However, if we only know it is a truncated terminal, we should let normal terminals take priority
+					// (Normal terminals are better information than truncations)
+					if (curTerminalType == TerminalType::NORMAL)
+						terminalType = curTerminalType;
 				}
+
+				// NOTE: We can't break since terminal conditions are guaranteed to be called once per step
 			}
-			state.terminals[arenaIdx] = terminalType;
-		}
-		
-		// Pre-step rewards
-		{
-			for (auto& weighted : rewards[arenaIdx])
-				weighted.reward->PreStep(gs);
 		}
+		state.terminals[arenaIdx] = terminalType;
+	}
+	
+	// Pre-step rewards
+	{
+		for (auto& weighted : rewards[arenaIdx])
+			weighted.reward->PreStep(gs);
+	}
 
-		// Update rewards
-		{
-			FList allRewards = FList(gs.players.size(), 0);
-			for (int rewardIdx = 0; rewardIdx < rewards[arenaIdx].size(); rewardIdx++) {
-				auto& weightedReward = rewards[arenaIdx][rewardIdx];
-				FList output = weightedReward.reward->GetAllRewards(gs, terminalType);
-				for (int i = 0; i < gs.players.size(); i++)
-					allRewards[i] += output[i] * weightedReward.weight;
-
-				// Save the reward
-				if (config.saveRewards) {
-					int playerSampleIndex;
-					if (config.shuffleRewardSampling) {
-						playerSampleIndex = Math::RandInt(0, output.size());
-					} else {
-						// Find player with the lowest id
-						playerSampleIndex = 0;
-						int lowestID = gs.players[0].carId;
-						for (int i = 1; i < gs.players.size(); i++) {
-							auto id = gs.players[i].carId;
-							if (id < lowestID) {
-								lowestID = id;
-								playerSampleIndex = i;
-							}
+	// Update rewards
+	{
+		FList allRewards = FList(gs.players.size(), 0);
+		for (int rewardIdx = 0; rewardIdx < rewards[arenaIdx].size(); rewardIdx++) {
+			auto& weightedReward = rewards[arenaIdx][rewardIdx];
+			FList output = weightedReward.reward->GetAllRewards(gs, terminalType);
+			for (int i = 0; i < gs.players.size(); i++)
+				allRewards[i] += output[i] * weightedReward.weight;
+
+			// Save the reward
+			if (config.saveRewards) {
+				int playerSampleIndex;
+				if (config.shuffleRewardSampling) {
+					playerSampleIndex = Math::RandInt(0, output.size());
+				} else {
+					// Find player with the lowest id
+					playerSampleIndex = 0;
+					int lowestID = gs.players[0].carId;
+					for (int i = 1; i < gs.players.size(); i++) {
+						auto id = gs.players[i].carId;
+						if (id < lowestID) {
+							lowestID = id;
+							playerSampleIndex = i;
 						}
 					}
-					// We will only take the reward from a random player
-					float rewardToSave = output[playerSampleIndex];
-						
-					// If zero-sum, use the inner reward
-					if (ZeroSumReward* zeroSum = dynamic_cast<ZeroSumReward*>(weightedReward.reward))
-						rewardToSave = zeroSum->_lastRewards[playerSampleIndex];
-
-					// If needed, initialize last rewards
-					if (state.lastRewards[arenaIdx].empty())
-						state.lastRewards[arenaIdx].resize(rewards[arenaIdx].size());
-
-					state.lastRewards[arenaIdx][rewardIdx] = rewardToSave;
 				}
+				// We will only take the reward from a random player
+				float rewardToSave = output[playerSampleIndex];
+					
+				// If zero-sum, use the inner reward
+				if (ZeroSumReward* zeroSum = dynamic_cast<ZeroSumReward*>(weightedReward.reward))
+					rewardToSave = zeroSum->_lastRewards[playerSampleIndex];
+
+				// If needed, initialize last rewards
+				if (state.lastRewards[arenaIdx].empty())
+					state.lastRewards[arenaIdx].resize(rewards[arenaIdx].size());
+
+				state.lastRewards[arenaIdx][rewardIdx] = rewardToSave;
 			}
-
-			for (int i = 0; i < gs.players.size(); i++)
-				state.rewards[playerStartIdx + i] = allRewards[i];
 		}
 
-		// Update observations
-		{
-			for (int i = 0; i < gs.players.size(); i++)
-				state.obs.Set(playerStartIdx + i, obsBuilders[arenaIdx]->BuildObs(gs.players[i], gs));
-		}
+		for (int i = 0; i < gs.players.size(); i++)
+			state.rewards[playerStartIdx + i] = allRewards[i];
+	}
 
-		// Update action masks
-		{
-			for (int i = 0; i < gs.players.size(); i++)
-				state.actionMasks.Set(playerStartIdx + i, actionParsers[arenaIdx]->GetActionMask(gs.players[i], gs));
+	// Update observations
+	{
+		for (int i = 0; i < gs.players.size(); i++) {
+			state.obs.Set(playerStartIdx + i, obsBuilders[arenaIdx]->BuildObs(gs.players[i], gs));
+			if (obsStandardizer)
+				obsStandardizer->Apply(arenaIdx, &state.obs.At(playerStartIdx + i, 0));
 		}
-	};
+	}
+
+	// Update action masks
+	{
+		for (int i = 0; i < gs.players.size(); i++)
+			state.actionMasks.Set(playerStartIdx + i, actionParsers[arenaIdx]->GetActionMask(gs.players[i], gs));
+	}
+
+	if (config.buildMirroredObs)
+		_BuildMirroredObs(arenaIdx, gs);
+
+	if (arenaStepCallback) {
+		RG_TRACE_SCOPE("Arena Step Callback", arenaIdx);
+		arenaStepCallback(arenaIdx);
+	}
+}
+
+void RLGC::EnvSet::_BuildMirroredObs(int arenaIdx, const GameState& gs) {
+	RG_TRACE_SCOPE("Build Mirrored Obs", arenaIdx);
+	GameState mirrored = MirrorStateX(gs);
+
+	int playerStartIdx = state.arenaPlayerStartIdx[arenaIdx];
+	for (int i = 0; i < mirrored.players.size(); i++) {
+		state.mirrorObs.Set(playerStartIdx + i, obsBuilders[arenaIdx]->BuildObs(mirrored.players[i], mirrored));
+		if (obsStandardizer)
+			obsStandardizer->Apply(arenaIdx, &state.mirrorObs.At(playerStartIdx + i, 0));
 
-	g_ThreadPool.StartBatchedJobs(fnStepArenas, arenas.size(), async);
+		state.mirrorActionMasks.Set(playerStartIdx + i, actionParsers[arenaIdx]->GetActionMask(mirrored.players[i], mirrored));
+	}
 }
 
 void RLGC::EnvSet::ResetArena(int index, const MyGL::GameState* scenarioState) {
+	RG_TRACE_SCOPE("Reset Arena", index);
+	ArenaRNGScope rngScope(&arenaRNGs[index]);
 	const MyGL::GameState* appliedScenarioState = scenarioState;
 	if (!appliedScenarioState && config.scenarioProvider) {
 		auto maybeScenario = config.scenarioProvider(index);
@@ -359,20 +465,28 @@ void RLGC::EnvSet::ResetArena(int index, const MyGL::GameState* scenarioState) {
 		// Update obs
 		auto obs = obsBuilders[index]->BuildObs(newState.players[i], newState);
 		state.obs.Set(playerStartIdx + i, obs);
+		if (obsStandardizer)
+			obsStandardizer->Apply(index, &state.obs.At(playerStartIdx + i, 0));
 
 		// Update action mask
 		auto actionMask = actionParsers[index]->GetActionMask(newState.players[i], newState);
 		state.actionMasks.Set(playerStartIdx + i, actionMask);
 	}
 
+	if (config.buildMirroredObs)
+		_BuildMirroredObs(index, newState);
+
 	// Remove previous state
 	state.prevGameStates[index].MakeEmpty();
 }
 
 void RLGC::EnvSet::Reset() {
-	for (int i = 0; i < arenas.size(); i++)
-		if (state.terminals[i])
-			g_ThreadPool.StartJobAsync([this](int idx) { ResetArena(idx); }, i);
+	for (int i = 0; i < arenas.size(); i++) {
+		if (state.terminals[i]) {
+			jobs.Add(1);
+			g_ThreadPool.StartJobAsync([this](int idx) { jobs.Run([&] { ResetArena(idx); }); }, i);
+		}
+	}
 	std::fill(state.terminals.begin(), state.terminals.end(), 0);
-	g_ThreadPool.WaitUntilDone();
+	Sync();
 }
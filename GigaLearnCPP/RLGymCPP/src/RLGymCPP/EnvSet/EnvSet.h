@@ -8,10 +8,12 @@
 #include "../BasicTypes/Action.h"
 #include "../TerminalConditions/TerminalCondition.h"
 #include "../Rewards/Reward.h"
-#include "../OBSBuilders/OBSBuilder.h"
+#include "../ObsBuilders/ObsBuilder.h"
 #include "../ActionParsers/ActionParser.h"
 #include "../StateSetters/StateSetter.h"
 #include "../ThreadPool.h"
+#include "../Random.h"
+#include "ObsStandardizer.h"
 #include <RLGymCPP/Rewards/Reward.h>
 
 namespace RLGC {
@@ -35,6 +37,18 @@ namespace RLGC {
 		int actionDelay;
 		bool saveRewards;
 		bool shuffleRewardSampling = true;
+
+		// Each arena gets its own random stream from this seed, so arena resets, obs builders, and reward sampling
+		//	are reproducible regardless of how the arenas are scheduled across threads
+		uint64_t randomSeed = 0;
+
+		// Arenas are split into this many shards, which can have their second half stepped separately
+		// This allows a shard to be stepping while the next one is still being inferred
+		int numShards = 1;
+
+		// Also build the obs and action masks of every player in the X-mirrored state (see MirrorStateX())
+		// Requires the action parser to support GetMirrorMap()
+		bool buildMirroredObs = false;
 		std::function<std::optional<MyGL::Scenario>(int index)> scenarioProvider;
 	};
 
@@ -42,8 +56,12 @@ namespace RLGC {
 		int numPlayers;
 		std::vector<GameState> gameStates;
 		std::vector<GameState> prevGameStates;
+		// NOTE: These are allocated once and never reallocated, so their memory can be safely viewed or pinned from outside
 		DimList2<float> obs;
 		DimList2<uint8_t> actionMasks;
+		DimList2<float> mirrorObs; // Only if EnvSetConfig::buildMirroredObs
+		DimList2<uint8_t> mirrorActionMasks;
+		IList actions; // Reusable storage for the actions passed to StepSecondHalf()
 		std::vector<float> rewards;
 		std::vector<std::vector<float>> lastRewards; // Only from the first arena
 		std::vector<uint8_t> terminals;
@@ -60,9 +78,46 @@ namespace RLGC {
 			gameStates.resize(arenas.size());
 			prevGameStates.resize(arenas.size());
 			rewards.resize(numPlayers);
+			actions.resize(numPlayers);
 			lastRewards.resize(arenas.size());
 			terminals.resize(arenas.size());
 		}
+
+		// Approximate bytes used by the state buffers (not including the arenas themselves)
+		uint64_t GetMemoryUsage() const {
+			uint64_t total = 0;
+			for (auto states : { &gameStates, &prevGameStates }) {
+				for (auto& state : *states) {
+					total += sizeof(GameState) + state.players.capacity() * sizeof(Player);
+					total += (state.boostPads.capacity() + state.boostPadsInv.capacity()) / 8;
+					total += (state.boostPadTimers.capacity() + state.boostPadTimersInv.capacity()) * sizeof(float);
+				}
+			}
+
+			for (auto& arenaRewards : lastRewards)
+				total += arenaRewards.capacity() * sizeof(float);
+
+			total += obs.data.capacity() * sizeof(float);
+			total += actionMasks.data.capacity() * sizeof(uint8_t);
+			total += mirrorObs.data.capacity() * sizeof(float);
+			total += mirrorActionMasks.data.capacity() * sizeof(uint8_t);
+			total += actions.capacity() * sizeof(int);
+			total += rewards.capacity() * sizeof(float);
+			total += terminals.capacity() * sizeof(uint8_t);
+			return total;
+		}
+	};
+
+	// A contiguous range of arenas (and their players)
+	struct EnvShard {
+		int arenaStart, arenaEnd;
+		int playerStart, playerEnd;
+
+		JobCounter* firstHalfJobs;
+
+		int GetNumPlayers() const {
+			return playerEnd - playerStart;
+		}
 	};
 
 	struct EnvSet {
@@ -94,6 +149,23 @@ namespace RLGC {
 
 		EnvState state = {};
 
+		// Index of the mirrored version of each action, only if EnvSetConfig::buildMirroredObs
+		std::vector<int> actionMirrorMap;
+
+		std::vector<PhiloxRNG> arenaRNGs; // Bound with ArenaRNGScope while the arena is created, reset or stepped
+
+		std::vector<EnvShard> shards;
+
+		// Every job started by this env set, so Sync() doesn't wait on unrelated work in the shared thread pool
+		JobCounter jobs;
+
+		// Optional, applied to every obs right after it is built (not owned)
+		ObsStandardizer* obsStandardizer = NULL;
+
+		// Optional, called with the arena index at the end of every arena step, from inside that arena's step job
+		// Different arenas are stepped in parallel, so this must be safe to run concurrently for different arenas
+		std::function<void(int arenaIdx)> arenaStepCallback = NULL;
+
 		EnvSet(const EnvSetConfig& config);
 
 		RG_NO_COPY(EnvSet);
@@ -106,13 +178,23 @@ namespace RLGC {
 				delete eventTracker;
 			for (auto& eventCallbackInfo : eventCallbackInfos)
 				delete eventCallbackInfo;
+
+			for (auto& shard : shards)
+				delete shard.firstHalfJobs;
 		}
 
 		////////////////////
 		
 		void StepFirstHalf(bool async);
 		void StepSecondHalf(const IList& actionIndices, bool async);
-		void Sync() { g_ThreadPool.WaitUntilDone(); }
+
+		// Steps the second half of only one shard's arenas, waiting for their first half to finish first
+		// actionIndices is indexed by global player index, and must remain valid until the jobs are done
+		void StepShardSecondHalf(int shardIdx, const IList& actionIndices, bool async);
+
+		void _StepArenaSecondHalf(int arenaIdx, const IList& actionIndices);
+		void _BuildMirroredObs(int arenaIdx, const GameState& gs);
+		void Sync() { jobs.Wait(); }
 		void ResetArena(int index, const MyGL::GameState* scenarioState = nullptr);
 		void Reset();
 	};
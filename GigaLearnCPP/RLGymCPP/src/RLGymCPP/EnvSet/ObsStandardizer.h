@@ -0,0 +1,73 @@
+#pragma once
+#include "../BasicTypes/Lists.h"
+
+namespace RLGC {
+
+	// Standardizes observations inside the env step jobs, right after they are built
+	// Obs are normalized with a float snapshot of the stats, which is only updated between steps (see SetStats())
+	// New samples go into a separate accumulator for each arena, so no locking is needed
+	struct ObsStandardizer {
+
+		// Running mean and sum of squared differences (Welford's M2)
+		struct Accumulator {
+			std::vector<double> means, m2s;
+			int64_t count = 0;
+
+			Accumulator(int width = 0) : means(width, 0), m2s(width, 0) {}
+
+			void IncrementRow(const float* samples) {
+				count++;
+				double countInv = 1.0 / count;
+				for (int i = 0; i < means.size(); i++) {
+					double delta = samples[i] - means[i];
+					means[i] += delta * countInv;
+					m2s[i] += delta * (samples[i] - means[i]);
+				}
+			}
+
+			void Reset() {
+				std::fill(means.begin(), means.end(), 0);
+				std::fill(m2s.begin(), m2s.end(), 0);
+				count = 0;
+			}
+		};
+
+		int obsSize;
+		float minSTD, maxMeanRange;
+
+		// Read-only snapshot of the stats used to normalize
+		FList mean, invSTD;
+
+		// If false, samples won't be accumulated
+		bool accumulate = true;
+		std::vector<Accumulator> accumulators; // One per arena
+
+		ObsStandardizer(int obsSize, int numArenas, float minSTD, float maxMeanRange) :
+			obsSize(obsSize), minSTD(minSTD), maxMeanRange(maxMeanRange),
+			mean(obsSize, 0), invSTD(obsSize, 1), accumulators(numArenas, Accumulator(obsSize)) {
+		}
+
+		RG_NO_COPY(ObsStandardizer);
+
+		// NOTE: Not thread-safe, don't call this while arenas are stepping
+		void SetStats(const std::vector<double>& newMean, const std::vector<double>& newSTD) {
+			RG_ASSERT(newMean.size() == obsSize && newSTD.size() == obsSize);
+			for (int i = 0; i < obsSize; i++) {
+				mean[i] = RS_CLAMP(newMean[i], -maxMeanRange, maxMeanRange);
+				invSTD[i] = 1 / RS_MAX(newSTD[i], minSTD);
+			}
+		}
+
+		// Accumulates (if enabled) and standardizes an obs in-place
+		void Apply(int arenaIdx, float* obs) {
+			if (accumulate)
+				accumulators[arenaIdx].IncrementRow(obs);
+
+			const float* __restrict meanData = mean.data();
+			const float* __restrict invSTDData = invSTD.data();
+			float* __restrict obsData = obs;
+			for (int i = 0; i < obsSize; i++)
+				obsData[i] = (obsData[i] - meanData[i]) * invSTDData[i];
+		}
+	};
+}
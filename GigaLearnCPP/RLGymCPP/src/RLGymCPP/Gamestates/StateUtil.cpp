@@ -33,4 +33,69 @@ PhysState RLGC::MirrorPhysX(const PhysState& physState, bool shouldMirror) {
 	}
 
 	return result;
-}
\ No newline at end of file
+}
+
+const std::vector<int>& RLGC::GetBoostPadMirrorMapX() {
+	static std::vector<int> mirrorMap = []() {
+		using namespace CommonValues;
+
+		// Pad locations aren't perfectly symmetric, so use the nearest pad
+		std::vector<int> result(BOOST_LOCATIONS_AMOUNT);
+		for (int i = 0; i < BOOST_LOCATIONS_AMOUNT; i++) {
+			Vec mirroredPos = BOOST_LOCATIONS[i] * Vec(-1, 1, 1);
+
+			int bestIdx = -1;
+			float bestDistSq = FLT_MAX;
+			for (int j = 0; j < BOOST_LOCATIONS_AMOUNT; j++) {
+				float distSq = BOOST_LOCATIONS[j].DistSq(mirroredPos);
+				if (distSq < bestDistSq) {
+					bestIdx = j;
+					bestDistSq = distSq;
+				}
+			}
+			result[i] = bestIdx;
+		}
+		return result;
+	}();
+
+	return mirrorMap;
+}
+
+RLGC::GameState RLGC::MirrorStateX(const GameState& state) {
+	GameState result = state;
+	result.prev = NULL;
+
+	(PhysState&)result.ball = MirrorPhysX(state.ball);
+
+	auto fnMirrorAction = [](Action& action) {
+		action.steer *= -1;
+		action.yaw *= -1;
+		action.roll *= -1;
+	};
+
+	for (Player& player : result.players) {
+		player.prev = NULL;
+		(PhysState&)player = MirrorPhysX(player);
+
+		player.worldContact.contactNormal.x *= -1;
+
+		// Local (forward, right, up) torque, with the right axis mirrored
+		player.flipRelTorque *= Vec(-1, 1, -1);
+
+		fnMirrorAction(player.prevAction);
+		player.lastControls.steer *= -1;
+		player.lastControls.yaw *= -1;
+		player.lastControls.roll *= -1;
+	}
+
+	auto& padMirrorMap = GetBoostPadMirrorMapX();
+	for (int i = 0; i < padMirrorMap.size(); i++) {
+		int j = padMirrorMap[i];
+		result.boostPads[j] = state.boostPads[i];
+		result.boostPadsInv[j] = state.boostPadsInv[i];
+		result.boostPadTimers[j] = state.boostPadTimers[i];
+		result.boostPadTimersInv[j] = state.boostPadTimersInv[i];
+	}
+
+	return result;
+}
@@ -1,7 +1,15 @@
 #pragma once
 #include "../Framework.h"
+#include "GameState.h"
 
 namespace RLGC {
 	PhysState InvertPhys(const PhysState& physState, bool shouldInvert = true);
 	PhysState MirrorPhysX(const PhysState& physState, bool shouldMirror = true);
+
+	// Index of the boost pad at the X-mirrored location of each boost pad
+	const std::vector<int>& GetBoostPadMirrorMapX();
+
+	// Returns the state mirrored across the X axis (left and right swapped), with mirrored player inputs
+	// Players keep their index, car ID, and team, and the result has no prev states
+	GameState MirrorStateX(const GameState& state);
 }
\ No newline at end of file
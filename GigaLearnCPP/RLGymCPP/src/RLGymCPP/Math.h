@@ -1,8 +1,18 @@
 #pragma once
 #include "Framework.h"
+#include "Random.h"
 
 namespace RLGC {
 	namespace Math {
+		// These draw from the current arena's generator (see GetArenaRNG())
+		inline float RandFloat(float min = 0, float max = 1) {
+			return GetArenaRNG().RandFloat(min, max);
+		}
+
+		inline int RandInt(int min, int max) {
+			return GetArenaRNG().RandInt(min, max);
+		}
+
 		Vec RandVec(Vec min, Vec max);
 
 		constexpr float VelToKPH(float vel) {
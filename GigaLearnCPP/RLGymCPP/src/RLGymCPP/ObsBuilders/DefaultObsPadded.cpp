@@ -1,5 +1,6 @@
 #include "DefaultObsPadded.h"
 #include "../Gamestates/StateUtil.h"
+#include "../Random.h"
 
 RLGC::FList RLGC::DefaultObsPadded::BuildObs(const Player& player, const GameState& state) {
 	FList result = {};
@@ -56,8 +57,8 @@ RLGC::FList RLGC::DefaultObsPadded::BuildObs(const Player& player, const GameSta
 	}
 
 	// Shuffle both lists
-	std::shuffle(teammates.begin(), teammates.end(), ::Math::GetRandEngine());
-	std::shuffle(opponents.begin(), opponents.end(), ::Math::GetRandEngine());
+	std::shuffle(teammates.begin(), teammates.end(), GetArenaRNG());
+	std::shuffle(opponents.begin(), opponents.end(), GetArenaRNG());
 
 	for (auto& teammate : teammates)
 		result += teammate;
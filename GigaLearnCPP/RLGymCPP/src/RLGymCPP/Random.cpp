@@ -0,0 +1,23 @@
+#include "Random.h"
+
+thread_local RLGC::PhiloxRNG* t_arenaRNG = NULL;
+
+RLGC::PhiloxRNG& RLGC::GetArenaRNG() {
+	if (t_arenaRNG)
+		return *t_arenaRNG;
+
+	static thread_local PhiloxRNG threadRNG = PhiloxRNG(
+		RS_CUR_MS(), std::hash<std::thread::id>()(std::this_thread::get_id())
+	);
+	return threadRNG;
+}
+
+RLGC::ArenaRNGScope::ArenaRNGScope(PhiloxRNG* rng) : prev(t_arenaRNG), prevSimEngine(RocketSim::Math::GetRandEngine()) {
+	t_arenaRNG = rng;
+	RocketSim::Math::GetRandEngine().seed((*rng)());
+}
+
+RLGC::ArenaRNGScope::~ArenaRNGScope() {
+	t_arenaRNG = prev;
+	RocketSim::Math::GetRandEngine() = prevSimEngine;
+}
@@ -0,0 +1,88 @@
+#pragma once
+#include "Framework.h"
+
+namespace RLGC {
+	// Counter-based random generator (Philox4x32-10)
+	// Each output block is a pure function of the key and counter, so streams with different keys/counters never overlap
+	//	and a stream's results don't depend on which thread draws from it
+	// Satisfies UniformRandomBitGenerator, so it works with std::shuffle and the std distributions
+	// Cache-line aligned so generators of arenas stepped on different threads don't share a line
+	struct alignas(64) PhiloxRNG {
+		typedef uint32_t result_type;
+
+		uint32_t key[2];
+		uint64_t stream;
+		uint64_t counter = 0;
+
+		uint32_t block[4];
+		int blockIdx = 4; // Next unused value in the block
+
+		PhiloxRNG(uint64_t seed = 0, uint64_t stream = 0) : stream(stream) {
+			key[0] = (uint32_t)seed;
+			key[1] = (uint32_t)(seed >> 32);
+		}
+
+		static constexpr result_type min() { return 0; }
+		static constexpr result_type max() { return UINT32_MAX; }
+
+		result_type operator()() {
+			if (blockIdx == 4) {
+				_GenerateBlock();
+				blockIdx = 0;
+			}
+			return block[blockIdx++];
+		}
+
+		// Uniform in [min, max]
+		float RandFloat(float min = 0, float max = 1) {
+			return min + ((*this)() * (1 / (float)UINT32_MAX)) * (max - min);
+		}
+
+		// Uniform in [min, max)
+		int RandInt(int min, int max) {
+			return min + (int)((*this)() % (uint32_t)(max - min));
+		}
+
+		void _GenerateBlock() {
+			constexpr uint32_t
+				M0 = 0xD2511F53, M1 = 0xCD9E8D57,
+				W0 = 0x9E3779B9, W1 = 0xBB67AE85;
+
+			uint32_t c[4] = { (uint32_t)counter, (uint32_t)(counter >> 32), (uint32_t)stream, (uint32_t)(stream >> 32) };
+			uint32_t k[2] = { key[0], key[1] };
+			for (int round = 0; round < 10; round++) {
+				uint64_t p0 = (uint64_t)M0 * c[0];
+				uint64_t p1 = (uint64_t)M1 * c[2];
+				uint32_t next[4] = {
+					(uint32_t)(p1 >> 32) ^ c[1] ^ k[0],
+					(uint32_t)p1,
+					(uint32_t)(p0 >> 32) ^ c[3] ^ k[1],
+					(uint32_t)p0
+				};
+				memcpy(c, next, sizeof(c));
+				k[0] += W0;
+				k[1] += W1;
+			}
+
+			memcpy(block, c, sizeof(block));
+			counter++;
+		}
+	};
+
+	// Returns the generator of the arena that this thread is currently resetting/stepping
+	// Outside of arena jobs, returns a per-thread generator (which isn't reproducible)
+	PhiloxRNG& GetArenaRNG();
+
+	// Makes GetArenaRNG() return this generator on the current thread until the scope ends
+	// RocketSim's own thread-local engine (used for things like demo respawns) is also reseeded from the generator,
+	//	and restored when the scope ends
+	struct ArenaRNGScope {
+		PhiloxRNG* prev;
+		std::default_random_engine prevSimEngine;
+
+		ArenaRNGScope(PhiloxRNG* rng);
+		~ArenaRNGScope();
+
+		RG_NO_COPY(ArenaRNGScope);
+	};
+}
@@ -32,7 +32,7 @@ namespace RLGC {
 		}
 
 		void ResetArena(Arena* arena) override {
-			float f = RocketSim::Math::RandFloat(0, totalWeight);
+			float f = Math::RandFloat(0, totalWeight);
 
 			for (int i = 0; i < setters.size(); i++) {
 				if (f <= cumulativeWeights[i]) {
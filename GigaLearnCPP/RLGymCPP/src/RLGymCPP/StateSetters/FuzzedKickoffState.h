@@ -1,5 +1,6 @@
 #pragma once
 #include "StateSetter.h"
+#include "../Math.h"
 
 namespace RLGC {
 	// Like KickoffState, but very slightly randomizes the cars
@@ -15,12 +16,12 @@ namespace RLGC {
 		);
 
 		void ResetArena(Arena* arena) {
-			arena->ResetToRandomKickoff();
+			arena->ResetToRandomKickoff(Math::RandInt(0, INT_MAX));
 
 			for (auto& car : arena->_cars) {
 				auto state = car->GetState();
 				for (int i = 0; i < 3; i++)
-					state.pos[i] += RocketSim::Math::RandFloat(-FUZZ_POS_RANGE, FUZZ_POS_RANGE);
+					state.pos[i] += Math::RandFloat(-FUZZ_POS_RANGE, FUZZ_POS_RANGE);
 				car->SetState(state);
 			}
 		}
@@ -1,11 +1,13 @@
 #pragma once
 #include "StateSetter.h"
+#include "../Math.h"
 
 namespace RLGC {
 	class KickoffState : public StateSetter {
 	public:
 		void ResetArena(Arena* arena) {
-			arena->ResetToRandomKickoff();
+			// Seeded from the arena's generator, so kickoffs are reproducible
+			arena->ResetToRandomKickoff(Math::RandInt(0, INT_MAX));
 		}
 	};
 }
\ No newline at end of file
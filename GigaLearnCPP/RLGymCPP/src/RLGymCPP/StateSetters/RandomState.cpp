@@ -1,7 +1,7 @@
 #include "RandomState.h"
 #include "../Math.h"
 
-using RocketSim::Math::RandFloat;
+using RLGC::Math::RandFloat;
 using RLGC::Math::RandVec;
 
 Vec RandNormVec() {
@@ -11,7 +11,7 @@ Vec RandNormVec() {
 void RLGC::RandomState::ResetArena(Arena* arena) {
 	
 	// Reset boost pads and everything
-	arena->ResetToRandomKickoff();
+	arena->ResetToRandomKickoff(Math::RandInt(0, INT_MAX));
 
 	constexpr float
 		X_MAX = 3500,
@@ -1,9 +1,61 @@
 #pragma once
 #include "Framework.h"
+#include "Tracer.h"
 
 #include <thread_pool.h>
+#include <condition_variable>
+#include <exception>
 
 namespace RLGC {
+	// Counts pending jobs so that a specific group of them can be waited on
+	// (ThreadPool::WaitUntilDone() waits for every job)
+	struct JobCounter {
+		std::mutex mutex;
+		std::condition_variable cv;
+		int pending = 0;
+		std::exception_ptr error; // First exception thrown by a job, rethrown by Wait()
+
+		void Add(int amount) {
+			std::lock_guard<std::mutex> lock(mutex);
+			pending += amount;
+		}
+
+		void Done(std::exception_ptr jobError = nullptr) {
+			// Notify under the lock, as the waiter may destroy the counter as soon as it sees zero
+			std::lock_guard<std::mutex> lock(mutex);
+			if (jobError && !error)
+				error = jobError;
+			pending--;
+			cv.notify_all();
+		}
+
+		// Runs a job that was added to this counter, and marks it done however it exits
+		// The thread pool swallows exceptions, so they are kept for Wait() instead
+		template <typename Function>
+		void Run(Function&& func) {
+			try {
+				func();
+			} catch (...) {
+				Done(std::current_exception());
+				return;
+			}
+			Done();
+		}
+
+		// Rethrows the first exception thrown by any of the jobs
+		void Wait() {
+			RG_TRACE_SCOPE("Wait For Job Group");
+			std::unique_lock<std::mutex> lock(mutex);
+			cv.wait(lock, [this] { return pending == 0; });
+
+			if (error) {
+				std::exception_ptr jobError = error;
+				error = nullptr;
+				std::rethrow_exception(jobError);
+			}
+		}
+	};
+
 	// Modified version of https://stackoverflow.com/questions/26516683/reusing-thread-in-loop-c
 	struct ThreadPool {
 
@@ -13,6 +65,10 @@ namespace RLGC {
 			_tp = new dp::thread_pool();
 		}
 
+		explicit ThreadPool(int numThreads) {
+			_tp = new dp::thread_pool(numThreads);
+		}
+
 		RG_NO_COPY(ThreadPool);
 
 		~ThreadPool() {
@@ -24,22 +80,41 @@ namespace RLGC {
 			_tp->enqueue_detach(func, args...);
 		}
 
-		void StartBatchedJobs(std::function<void(int)> func, int num, bool async) {
-
-			for (int i = 0; i < num; i++)
-				StartJobAsync(func, i);
+		// Starts the jobs as part of a group, so they can be waited on with counter.Wait() without waiting for unrelated jobs
+		void StartCountedJobs(std::function<void(int)> func, int num, JobCounter& counter) {
+			counter.Add(num);
+			for (int i = 0; i < num; i++) {
+				StartJobAsync([func, &counter](int idx) { counter.Run([&] { func(idx); }); }, i);
+			}
+		}
 
-			if (!async)
-				WaitUntilDone();
+		// If not async, waits for only these jobs to finish
+		void StartBatchedJobs(std::function<void(int)> func, int num, bool async) {
+			if (async) {
+				for (int i = 0; i < num; i++)
+					StartJobAsync(func, i);
+			} else {
+				JobCounter counter;
+				StartCountedJobs(func, num, counter);
+				counter.Wait();
+			}
 		}
 
 		void WaitUntilDone() {
+			RG_TRACE_SCOPE("Wait For All Jobs");
 			_tp->wait_for_tasks();
 		}
 
 		int GetNumThreads() const {
 			return _tp->size();
 		}
+
+		// Waits for all jobs, then replaces the pool with one of the given size
+		void Resize(int numThreads) {
+			WaitUntilDone();
+			delete _tp;
+			_tp = new dp::thread_pool(numThreads);
+		}
 	};
 
 	extern ThreadPool g_ThreadPool;
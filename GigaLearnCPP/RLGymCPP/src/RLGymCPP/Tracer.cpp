@@ -0,0 +1,114 @@
+#include "Tracer.h"
+
+#include <iomanip>
+
+RLGC::Tracer RLGC::g_Tracer = {};
+
+// Shared with the tracer so the events outlive the thread
+thread_local std::shared_ptr<RLGC::Tracer::ThreadBuffer> t_threadBuffer = NULL;
+thread_local std::string t_threadName = {};
+
+void RLGC::Tracer::Start() {
+	{
+		std::lock_guard<std::mutex> lock(buffersMutex);
+
+		// Forget threads that have exited
+		std::erase_if(buffers, [](const std::shared_ptr<ThreadBuffer>& buffer) { return buffer.use_count() == 1; });
+
+		for (auto& buffer : buffers)
+			buffer->numWritten = 0;
+	}
+
+	startTimeNs = NowNs();
+	enabled = true;
+}
+
+void RLGC::Tracer::Stop() {
+	enabled = false;
+}
+
+RLGC::Tracer::ThreadBuffer& RLGC::Tracer::_GetThreadBuffer() {
+	// Only made once a thread records something, so threads that never record while tracing cost nothing
+	if (!t_threadBuffer) {
+		t_threadBuffer = std::make_shared<ThreadBuffer>();
+		t_threadBuffer->events.resize(THREAD_BUFFER_SIZE);
+
+		std::lock_guard<std::mutex> lock(buffersMutex);
+		t_threadBuffer->threadID = nextThreadID++;
+		t_threadBuffer->threadName = t_threadName.empty() ? RS_STR("Thread " << t_threadBuffer->threadID) : t_threadName;
+		buffers.push_back(t_threadBuffer);
+	}
+
+	return *t_threadBuffer;
+}
+
+void RLGC::Tracer::Record(const char* name, uint64_t startNs, uint64_t endNs, int64_t arg) {
+	ThreadBuffer& buffer = _GetThreadBuffer();
+	uint64_t index = buffer.numWritten.load(std::memory_order_relaxed);
+	buffer.events[index % THREAD_BUFFER_SIZE] = Event{ name, arg, startNs, endNs };
+	buffer.numWritten.store(index + 1, std::memory_order_release);
+}
+
+void RLGC::Tracer::SetThreadName(const std::string& name) {
+	t_threadName = name;
+	if (t_threadBuffer) {
+		std::lock_guard<std::mutex> lock(buffersMutex);
+		t_threadBuffer->threadName = name;
+	}
+}
+
+// Minimal JSON string escaping for event and thread names
+static std::string EscapeJSON(const std::string& str) {
+	std::string result = {};
+	for (char c : str) {
+		if (c == '"' || c == '\\') {
+			result += '\\';
+			result += c;
+		} else if ((unsigned char)c < 0x20) {
+			result += ' ';
+		} else {
+			result += c;
+		}
+	}
+	return result;
+}
+
+void RLGC::Tracer::WriteJSON(std::filesystem::path path) {
+	std::ofstream fOut(path);
+	if (!fOut.good())
+		RG_ERR_CLOSE("Tracer::WriteJSON(): Can't open file at " << path);
+
+	std::lock_guard<std::mutex> lock(buffersMutex);
+
+	fOut << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n";
+	bool first = true;
+	auto fnSeparate = [&]() {
+		if (!first)
+			fOut << ",\n";
+		first = false;
+	};
+
+	fOut << std::fixed << std::setprecision(3);
+	for (auto& buffer : buffers) {
+		fnSeparate();
+		fOut << "{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":0,\"tid\":" << buffer->threadID << ",\"args\":{\"name\":\"" << EscapeJSON(buffer->threadName) << "\"}}";
+
+		uint64_t numWritten = buffer->numWritten.load(std::memory_order_acquire);
+		uint64_t firstIndex = (numWritten > THREAD_BUFFER_SIZE) ? (numWritten - THREAD_BUFFER_SIZE) : 0;
+		for (uint64_t i = firstIndex; i < numWritten; i++) {
+			Event event = buffer->events[i % THREAD_BUFFER_SIZE];
+			if (event.startNs < startTimeNs)
+				continue; // Started before this trace
+
+			// Timestamps are in microseconds
+			fnSeparate();
+			fOut << "{\"ph\":\"X\",\"name\":\"" << EscapeJSON(event.name) << "\",\"pid\":0,\"tid\":" << buffer->threadID
+				<< ",\"ts\":" << ((event.startNs - startTimeNs) / 1000.0) << ",\"dur\":" << ((event.endNs - event.startNs) / 1000.0);
+			if (event.arg != -1)
+				fOut << ",\"args\":{\"arg\":" << event.arg << "}";
+			fOut << "}";
+		}
+	}
+
+	fOut << "\n]}\n";
+}
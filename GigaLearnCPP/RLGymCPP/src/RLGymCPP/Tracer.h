@@ -0,0 +1,84 @@
+#pragma once
+#include "Framework.h"
+
+#include <atomic>
+
+namespace RLGC {
+	// Scoped-event tracer that writes Chrome/Perfetto trace JSON (open in ui.perfetto.dev or chrome://tracing)
+	// Each thread records into its own ring buffer, so recording never takes a lock
+	// When disabled, a trace scope costs a single atomic load
+	struct Tracer {
+		struct Event {
+			const char* name; // Must be a string literal (or otherwise outlive the trace)
+			int64_t arg; // Shown as "arg" if not -1, e.g. an arena index
+			uint64_t startNs, endNs;
+		};
+
+		struct ThreadBuffer {
+			int threadID;
+			std::string threadName;
+			std::vector<Event> events;
+			std::atomic<uint64_t> numWritten = 0; // Total events ever written, the ring index is this modulo the capacity
+		};
+
+		// Per-thread event capacity, the oldest events are overwritten past this
+		constexpr static size_t THREAD_BUFFER_SIZE = 1 << 16;
+
+		std::atomic<bool> enabled = false;
+		uint64_t startTimeNs = 0;
+
+		std::mutex buffersMutex;
+		std::vector<std::shared_ptr<ThreadBuffer>> buffers;
+		int nextThreadID = 0;
+
+		static uint64_t NowNs() {
+			return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+		}
+
+		bool IsEnabled() const {
+			return enabled.load(std::memory_order_relaxed);
+		}
+
+		// Clears all recorded events and starts recording
+		void Start();
+
+		// Stops recording, events are kept until the next Start()
+		void Stop();
+
+		void Record(const char* name, uint64_t startNs, uint64_t endNs, int64_t arg = -1);
+
+		// Names the calling thread in the trace, cheap enough to call whenever a thread starts
+		void SetThreadName(const std::string& name);
+
+		// Should be called after Stop(), threads still recording while this runs may leave torn events
+		void WriteJSON(std::filesystem::path path);
+
+		ThreadBuffer& _GetThreadBuffer();
+	};
+
+	extern Tracer g_Tracer;
+
+	struct TraceScope {
+		const char* name;
+		int64_t arg;
+		uint64_t startNs = 0;
+
+		TraceScope(const char* name, int64_t arg = -1) : name(name), arg(arg) {
+			if (g_Tracer.IsEnabled())
+				startNs = Tracer::NowNs();
+		}
+
+		RG_NO_COPY(TraceScope);
+
+		~TraceScope() {
+			if (startNs && g_Tracer.IsEnabled())
+				g_Tracer.Record(name, startNs, Tracer::NowNs(), arg);
+		}
+	};
+}
+
+#define _RG_TRACE_CONCAT_INNER(a, b) a##b
+#define _RG_TRACE_CONCAT(a, b) _RG_TRACE_CONCAT_INNER(a, b)
+
+// Records the rest of the current scope as a trace event, optionally with an integer arg
+#define RG_TRACE_SCOPE(...) RLGC::TraceScope _RG_TRACE_CONCAT(_traceScope, __LINE__)(__VA_ARGS__)
@@ -0,0 +1,263 @@
+#include "Autotuner.h"
+
+#include <GigaLearnCPP/Util/Utils.h>
+#include <GigaLearnCPP/Util/Timer.h>
+#include <torch/cuda.h>
+
+using namespace nlohmann;
+
+nlohmann::json GGL::AutotuneResult::ToJSON() const {
+	json j = {};
+	j["num_games"] = numGames;
+	j["num_threads"] = numThreads;
+	j["torch_threads"] = torchThreads;
+	j["mini_batch_size"] = miniBatchSize;
+	j["collection_sps"] = collectionSPS;
+	j["consumption_sps"] = consumptionSPS;
+	j["overall_sps"] = overallSPS;
+	return j;
+}
+
+GGL::AutotuneResult GGL::AutotuneResult::FromJSON(const nlohmann::json& j) {
+	AutotuneResult result = {};
+	result.numGames = j["num_games"];
+	result.numThreads = j["num_threads"];
+	result.torchThreads = j["torch_threads"];
+	result.miniBatchSize = j["mini_batch_size"];
+	result.collectionSPS = j["collection_sps"];
+	result.consumptionSPS = j["consumption_sps"];
+	result.overallSPS = j["overall_sps"];
+	return result;
+}
+
+// Identifies everything that affects the result besides the host, so a cached result is only reused if it still applies
+static std::string MakeCacheKey(const GGL::LearnerConfig& config, GGL::PPOLearner* ppo, int obsSize, int numActions) {
+	auto& autotune = config.autotune;
+
+	uint64_t paramCount = 0;
+	for (auto& pair : ppo->models.map)
+		paramCount += pair.second->GetParamCount();
+
+	json j = {};
+	j["device"] = ppo->device.str();
+	j["obs_size"] = obsSize;
+	j["num_actions"] = numActions;
+	j["param_count"] = paramCount;
+	j["ts_per_itr"] = config.ppo.tsPerItr;
+	j["batch_size"] = config.ppo.batchSize;
+	j["epochs"] = config.ppo.epochs;
+	j["mixed_precision_learn"] = config.ppo.mixedPrecisionLearn;
+	j["pipelined"] = config.collectionPolicyLag > 0;
+	j["num_shards"] = config.numEnvShards;
+	j["grid"] = { autotune.numGames, autotune.numThreads, autotune.torchThreads, autotune.miniBatchSizes };
+	j["max_memory_mb"] = autotune.maxMemoryMB;
+	return j.dump();
+}
+
+// Returns player steps per second, inferring and stepping the same way collection does
+static double RunCollectionTrial(RLGC::EnvSet* envSet, GGL::PPOLearner* ppo, const GGL::AutotuneConfig& config) {
+	RG_NO_GRAD;
+
+	GGL::ModelSet policyModels = ppo->GetPolicyModels();
+	int numPlayers = envSet->state.numPlayers;
+
+	GGL::Timer timer = {};
+	for (int step = 0; step < config.trialWarmupSteps + config.trialSteps; step++) {
+		if (step == config.trialWarmupSteps)
+			timer.Reset();
+
+		envSet->Reset();
+
+		torch::Tensor tStates = GGL::DIMLIST2_TO_TENSOR<float>(envSet->state.obs).to(ppo->device, true);
+		torch::Tensor tActionMasks = GGL::DIMLIST2_TO_TENSOR<uint8_t>(envSet->state.actionMasks).to(ppo->device, true);
+
+		envSet->StepFirstHalf(true);
+
+		torch::Tensor tActions;
+		ppo->InferActions(tStates, tActionMasks, &tActions, NULL, &policyModels);
+		tActions = tActions.cpu().to(torch::kInt32).contiguous();
+		memcpy(envSet->state.actions.data(), tActions.const_data_ptr<int32_t>(), numPlayers * sizeof(int32_t));
+
+		for (int shardIdx = 0; shardIdx < envSet->shards.size(); shardIdx++)
+			envSet->StepShardSecondHalf(shardIdx, envSet->state.actions, true);
+		envSet->Sync();
+	}
+
+	return (double)config.trialSteps * numPlayers / timer.Elapsed();
+}
+
+// Returns samples learned from per second (one epoch)
+// Runs the same forward and backward passes as learning, but never steps the optimizers, so the models are left untouched
+static double RunLearnTrial(GGL::PPOLearner* ppo, int obsSize, int numActions, int64_t miniBatchSize, int64_t numSamples, bool mixedPrecision) {
+	auto device = ppo->device;
+
+	// The CPU learns each batch in one pass
+	int64_t passSize = device.is_cpu() ? RS_MIN(ppo->config.batchSize, numSamples) : miniBatchSize;
+	int numPasses = RS_MAX(numSamples / passSize, 1);
+
+	torch::Tensor obs = torch::randn({ passSize, obsSize }).to(device);
+	torch::Tensor actionMasks = torch::ones({ passSize, numActions }, torch::kUInt8).to(device);
+
+	auto fnSync = [&]() {
+		if (device.is_cuda())
+			torch::cuda::synchronize();
+	};
+
+	GGL::Timer timer = {};
+	for (int i = 0; i < numPasses + 1; i++) {
+		if (i == 1) {
+			// First pass is warmup
+			fnSync();
+			timer.Reset();
+		}
+
+		torch::Tensor probs, vals;
+		GGL::PPOLearner::ForwardActorCritic(ppo->models, obs, actionMasks, ppo->config.policyTemperature, mixedPrecision, &probs, &vals);
+		torch::Tensor loss = probs.log().mean() + vals.mean();
+		loss.backward();
+	}
+	fnSync();
+	double elapsed = timer.Elapsed();
+
+	for (auto& pair : ppo->models.map)
+		pair.second->optim->zero_grad();
+
+	return (double)numPasses * passSize / elapsed;
+}
+
+GGL::AutotuneResult GGL::Autotuner::Run(const LearnerConfig& config, RLGC::EnvSetConfig envSetConfig, PPOLearner* ppo, int obsSize, int numActions) {
+	auto& autotune = config.autotune;
+
+	RG_LOG("Autotuner:");
+
+	std::string hostName = Utils::GetHostName();
+	std::string cacheKey = MakeCacheKey(config, ppo, obsSize, numActions);
+
+	json cache = {};
+	if (!autotune.cachePath.empty() && std::filesystem::exists(autotune.cachePath)) {
+		try {
+			std::ifstream fIn(autotune.cachePath);
+			cache = json::parse(fIn);
+		} catch (std::exception& e) {
+			RG_LOG("\tWARNING: Failed to read autotune cache at " << autotune.cachePath << " (" << e.what() << "), it will be replaced");
+			cache = {};
+		}
+
+		if (cache.contains(hostName) && cache[hostName].contains(cacheKey)) {
+			AutotuneResult result = AutotuneResult::FromJSON(cache[hostName][cacheKey]);
+			RG_LOG("\tUsing cached result for host \"" << hostName << "\"");
+			RG_LOG(
+				"\t > Games: " << result.numGames << ", threads: " << result.numThreads << ", torch threads: " << result.torchThreads <<
+				", minibatch size: " << result.miniBatchSize << " (" << (int)result.overallSPS << " steps/second)"
+			);
+			return result;
+		}
+	}
+
+	// Empty lists keep the current value
+	std::vector<int> gameCounts = autotune.numGames.empty() ? std::vector<int>{ config.numGames } : autotune.numGames;
+	std::vector<int> threadCounts = autotune.numThreads.empty() ? std::vector<int>{ RLGC::g_ThreadPool.GetNumThreads() } : autotune.numThreads;
+	std::vector<int> torchThreadCounts = autotune.torchThreads.empty() ? std::vector<int>{ torch::get_num_threads() } : autotune.torchThreads;
+	std::vector<int64_t> miniBatchSizes = {};
+	if (ppo->device.is_cpu() || autotune.miniBatchSizes.empty()) {
+		miniBatchSizes.push_back(ppo->config.miniBatchSize);
+	} else {
+		for (int64_t miniBatchSize : autotune.miniBatchSizes) {
+			if (miniBatchSize > 0 && ppo->config.batchSize % miniBatchSize == 0) {
+				miniBatchSizes.push_back(miniBatchSize);
+			} else {
+				RG_LOG("\tWARNING: Skipping minibatch size " << miniBatchSize << ", batch size (" << ppo->config.batchSize << ") must be a multiple of it");
+			}
+		}
+
+		if (miniBatchSizes.empty())
+			miniBatchSizes.push_back(ppo->config.miniBatchSize);
+	}
+	std::sort(gameCounts.begin(), gameCounts.end());
+
+	// Learning trials
+	// Consumption steps/second by torch thread count, then minibatch size
+	std::map<int, std::map<int64_t, double>> consumptionSPS = {};
+	for (int torchThreads : torchThreadCounts) {
+		torch::set_num_threads(torchThreads);
+		for (int64_t miniBatchSize : miniBatchSizes) {
+			double samplesPerSecond = RunLearnTrial(ppo, obsSize, numActions, miniBatchSize, autotune.trialLearnSamples, ppo->config.mixedPrecisionLearn);
+			double sps = samplesPerSecond / config.ppo.epochs; // Each collected step is learned from once per epoch
+			consumptionSPS[torchThreads][miniBatchSize] = sps;
+			RG_LOG("\tLearn trial (torch threads: " << torchThreads << ", minibatch size: " << miniBatchSize << "): " << (int)sps << " steps/second");
+		}
+	}
+
+	// Collection and consumption run back-to-back, unless collection is pipelined
+	bool pipelined = config.collectionPolicyLag > 0;
+	auto fnCombineSPS = [&](double collection, double consumption) {
+		return pipelined ? RS_MIN(collection, consumption) : 1 / (1 / collection + 1 / consumption);
+	};
+
+	// Collection trials
+	uint64_t maxMemory = (uint64_t)autotune.maxMemoryMB * 1024 * 1024;
+	uint64_t baseMemory = Utils::GetProcessMemoryUsage();
+	double bytesPerArena = -1; // Measured from the first env, then extrapolated
+
+	AutotuneResult best = {};
+	best.overallSPS = -1;
+	for (int numGames : gameCounts) {
+		if (maxMemory && bytesPerArena >= 0 && baseMemory + bytesPerArena * numGames > maxMemory) {
+			RG_LOG("\tSkipping " << numGames << " games, estimated memory usage is over the limit");
+			continue;
+		}
+
+		envSetConfig.numArenas = numGames;
+		uint64_t memoryBefore = Utils::GetProcessMemoryUsage();
+		RLGC::EnvSet* envSet = new RLGC::EnvSet(envSetConfig);
+		if (bytesPerArena < 0) {
+			uint64_t memoryAfter = Utils::GetProcessMemoryUsage();
+			bytesPerArena = (memoryAfter > memoryBefore) ? (double)(memoryAfter - memoryBefore) / numGames : 0;
+			RG_LOG("\tEnv memory usage: ~" << (int)(bytesPerArena / 1024) << "KB per arena");
+
+			if (maxMemory && baseMemory + bytesPerArena * numGames > maxMemory) {
+				RG_LOG("\tSkipping " << numGames << " games, estimated memory usage is over the limit");
+				delete envSet;
+				continue;
+			}
+		}
+
+		for (int numThreads : threadCounts) {
+			RLGC::g_ThreadPool.Resize(numThreads);
+			for (int torchThreads : torchThreadCounts) {
+				torch::set_num_threads(torchThreads);
+
+				double collectionSPS = RunCollectionTrial(envSet, ppo, autotune);
+				RG_LOG("\tCollection trial (games: " << numGames << ", threads: " << numThreads << ", torch threads: " << torchThreads << "): " << (int)collectionSPS << " steps/second");
+
+				for (auto& pair : consumptionSPS[torchThreads]) {
+					double overallSPS = fnCombineSPS(collectionSPS, pair.second);
+					if (overallSPS > best.overallSPS)
+						best = AutotuneResult{ numGames, numThreads, torchThreads, pair.first, collectionSPS, pair.second, overallSPS };
+				}
+			}
+		}
+
+		delete envSet;
+	}
+
+	if (best.overallSPS < 0)
+		RG_ERR_CLOSE("Autotuner: No configuration fits within config.autotune.maxMemoryMB (" << autotune.maxMemoryMB << "MB)");
+
+	RG_LOG(
+		"\t > Best: games: " << best.numGames << ", threads: " << best.numThreads << ", torch threads: " << best.torchThreads <<
+		", minibatch size: " << best.miniBatchSize << " (" << (int)best.overallSPS << " overall steps/second)"
+	);
+
+	if (!autotune.cachePath.empty()) {
+		cache[hostName][cacheKey] = best.ToJSON();
+		std::ofstream fOut(autotune.cachePath);
+		if (fOut.good()) {
+			fOut << cache.dump(4);
+		} else {
+			RG_LOG("\tWARNING: Failed to write autotune cache to " << autotune.cachePath);
+		}
+	}
+
+	return best;
+}
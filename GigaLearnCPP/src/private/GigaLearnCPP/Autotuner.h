@@ -0,0 +1,28 @@
+#pragma once
+#include <GigaLearnCPP/LearnerConfig.h>
+#include "PPO/PPOLearner.h"
+
+#include <nlohmann/json.hpp>
+
+namespace GGL {
+	struct AutotuneResult {
+		int numGames;
+		int numThreads;
+		int torchThreads;
+		int64_t miniBatchSize;
+
+		// Measured during the trials
+		double collectionSPS, consumptionSPS, overallSPS;
+
+		nlohmann::json ToJSON() const;
+		static AutotuneResult FromJSON(const nlohmann::json& j);
+	};
+
+	namespace Autotuner {
+		// Runs collection trials for each numGames/thread count and learning trials for each torch thread count/minibatch size,
+		// then returns the combination with the highest estimated overall steps/second
+		// The result is read from the cache instead if this host was already calibrated with the same settings
+		// NOTE: The thread pool and torch thread count are left changed, apply the result afterwards
+		AutotuneResult Run(const LearnerConfig& config, RLGC::EnvSetConfig envSetConfig, PPOLearner* ppo, int obsSize, int numActions);
+	}
+}
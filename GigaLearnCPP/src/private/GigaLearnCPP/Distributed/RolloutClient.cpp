@@ -0,0 +1,80 @@
+#include "RolloutClient.h"
+
+GGL::RolloutClient::RolloutClient(const std::string& host, int port) {
+	RG_LOG("RolloutClient: Connecting to learner at " << host << ":" << port << "...");
+
+	socket = Socket::Connect(host, port);
+	if (!socket.IsValid())
+		RG_ERR_CLOSE("RolloutClient: Failed to connect to learner at " << host << ":" << port);
+
+	RG_LOG(" > Connected.");
+	recvThread = std::thread([this]() { _RecvLoop(); });
+}
+
+bool GGL::RolloutClient::TakeLatestPolicy(RolloutPolicy& outPolicy, bool wait) {
+	std::unique_lock<std::mutex> lock(policyMutex);
+
+	if (wait)
+		policyCondition.wait(lock, [this]() { return hasNewPolicy || !connected; });
+
+	if (!hasNewPolicy)
+		return false;
+
+	outPolicy = std::move(latestPolicy);
+	latestPolicy = {};
+	hasNewPolicy = false;
+	return true;
+}
+
+bool GGL::RolloutClient::SendChunk(const RolloutChunk& chunk) {
+	std::vector<uint8_t> bytes = chunk.Serialize();
+
+	std::lock_guard<std::mutex> lock(sendMutex);
+	if (!connected || !SendRolloutMsg(socket, RolloutMsgType::CHUNK, bytes)) {
+		connected = false;
+		return false;
+	}
+
+	return true;
+}
+
+void GGL::RolloutClient::_RecvLoop() {
+	RolloutMsgType msgType;
+	std::vector<uint8_t> msgData;
+	while (connected && RecvRolloutMsg(socket, msgType, msgData)) {
+		if (msgType != RolloutMsgType::POLICY) {
+			RG_LOG("RolloutClient: Learner sent an unexpected message (type " << (int)msgType << "), disconnecting");
+			break;
+		}
+
+		// Older policies that haven't been taken yet are just replaced
+		RolloutPolicy policy;
+		try {
+			policy = RolloutPolicy::Deserialize(msgData);
+		} catch (std::exception& e) {
+			RG_LOG("RolloutClient: Learner sent a malformed policy, disconnecting (" << e.what() << ")");
+			break;
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(policyMutex);
+			latestPolicy = std::move(policy);
+			hasNewPolicy = true;
+		}
+		policyCondition.notify_all();
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(policyMutex);
+		connected = false;
+	}
+	socket.Shutdown();
+	policyCondition.notify_all();
+}
+
+GGL::RolloutClient::~RolloutClient() {
+	connected = false;
+	socket.Shutdown();
+	if (recvThread.joinable())
+		recvThread.join();
+}
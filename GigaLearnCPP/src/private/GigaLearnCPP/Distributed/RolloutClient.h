@@ -0,0 +1,35 @@
+#pragma once
+#include "RolloutMessages.h"
+
+namespace GGL {
+
+	// Runs on a rollout worker, sends experience chunks to the learner and receives new policies
+	class RolloutClient {
+	public:
+		Socket socket;
+		std::thread recvThread;
+		std::mutex sendMutex;
+
+		std::mutex policyMutex;
+		std::condition_variable policyCondition;
+		RolloutPolicy latestPolicy = {};
+		bool hasNewPolicy = false;
+		std::atomic<bool> connected = true;
+
+		// Throws if the connection fails
+		RolloutClient(const std::string& host, int port);
+		RG_NO_COPY(RolloutClient);
+
+		// Takes the newest policy received since the last call
+		// If wait is true, blocks until one arrives
+		// Returns false if there is no new policy (or the connection was lost)
+		bool TakeLatestPolicy(RolloutPolicy& outPolicy, bool wait);
+
+		// Returns false if the connection was lost
+		bool SendChunk(const RolloutChunk& chunk);
+
+		~RolloutClient();
+
+		void _RecvLoop();
+	};
+}
@@ -0,0 +1,222 @@
+#include "RolloutMessages.h"
+
+namespace {
+	struct ByteWriter {
+		std::vector<uint8_t>& bytes;
+
+		ByteWriter(std::vector<uint8_t>& bytes) : bytes(bytes) {}
+
+		void WriteBytes(const void* data, size_t size) {
+			const uint8_t* start = (const uint8_t*)data;
+			bytes.insert(bytes.end(), start, start + size);
+		}
+
+		template <typename T>
+		void Write(const T& val) {
+			static_assert(std::is_trivially_copyable<T>::value);
+			WriteBytes(&val, sizeof(T));
+		}
+
+		void WriteString(const std::string& str) {
+			Write<uint32_t>(str.size());
+			WriteBytes(str.data(), str.size());
+		}
+
+		template <typename T>
+		void WriteVec(const std::vector<T>& vec) {
+			Write<uint64_t>(vec.size());
+			WriteBytes(vec.data(), vec.size() * sizeof(T));
+		}
+
+		void WriteTensor(torch::Tensor tensor) {
+			Write<uint8_t>(tensor.defined());
+			if (!tensor.defined())
+				return;
+
+			tensor = tensor.cpu().contiguous();
+
+			Write<int32_t>((int32_t)tensor.scalar_type());
+			Write<uint32_t>(tensor.dim());
+			for (int64_t size : tensor.sizes())
+				Write<int64_t>(size);
+			WriteBytes(tensor.data_ptr(), tensor.nbytes());
+		}
+	};
+
+	struct ByteReader {
+		const std::vector<uint8_t>& bytes;
+		size_t pos = 0;
+
+		ByteReader(const std::vector<uint8_t>& bytes) : bytes(bytes) {}
+
+		size_t GetRemaining() const {
+			return bytes.size() - pos;
+		}
+
+		// Sizes come from the peer, so they are checked before anything is allocated for them
+		void CheckRemaining(uint64_t count, size_t elemSize) {
+			if (elemSize > 0 && count > GetRemaining() / elemSize)
+				RG_ERR_CLOSE("RolloutMessages: Message is truncated or corrupt (tried to read past end)");
+		}
+
+		void ReadBytes(void* out, size_t size) {
+			CheckRemaining(size, 1);
+			memcpy(out, bytes.data() + pos, size);
+			pos += size;
+		}
+
+		template <typename T>
+		T Read() {
+			T val;
+			ReadBytes(&val, sizeof(T));
+			return val;
+		}
+
+		std::string ReadString() {
+			uint32_t size = Read<uint32_t>();
+			CheckRemaining(size, 1);
+			std::string str(size, '\0');
+			ReadBytes(str.data(), str.size());
+			return str;
+		}
+
+		template <typename T>
+		std::vector<T> ReadVec() {
+			uint64_t size = Read<uint64_t>();
+			CheckRemaining(size, sizeof(T));
+			std::vector<T> vec(size);
+			ReadBytes(vec.data(), vec.size() * sizeof(T));
+			return vec;
+		}
+
+		torch::Tensor ReadTensor() {
+			if (!Read<uint8_t>())
+				return {};
+
+			int32_t dtypeIdx = Read<int32_t>();
+			if (dtypeIdx < 0 || dtypeIdx >= (int32_t)torch::ScalarType::NumOptions)
+				RG_ERR_CLOSE("RolloutMessages: Message has an invalid tensor dtype (" << dtypeIdx << ")");
+			auto dtype = (torch::ScalarType)dtypeIdx;
+			size_t elemSize = c10::elementSize(dtype);
+
+			uint32_t dim = Read<uint32_t>();
+			CheckRemaining(dim, sizeof(int64_t));
+			std::vector<int64_t> sizes(dim);
+			uint64_t numel = 1;
+			for (int64_t& size : sizes) {
+				size = Read<int64_t>();
+				if (size < 0)
+					RG_ERR_CLOSE("RolloutMessages: Message has a negative tensor size");
+
+				// Checking as we go also keeps numel from overflowing
+				if (size > 0 && numel > GetRemaining() / size)
+					RG_ERR_CLOSE("RolloutMessages: Message is truncated or corrupt (tried to read past end)");
+				numel *= size;
+			}
+			CheckRemaining(numel, elemSize);
+
+			torch::Tensor tensor = torch::empty(sizes, dtype);
+			ReadBytes(tensor.data_ptr(), tensor.nbytes());
+			return tensor;
+		}
+	};
+}
+
+std::vector<uint8_t> GGL::RolloutChunk::Serialize() const {
+	std::vector<uint8_t> bytes = {};
+	ByteWriter writer = ByteWriter(bytes);
+
+	writer.Write(policyVersion);
+	writer.Write(stepsCollected);
+	writer.Write(collectionTime);
+
+	for (auto& tensor : { states, actionMasks, actions, logProbs, rewards, terminals, values })
+		writer.WriteTensor(tensor);
+	writer.WriteVec(truncNextStates);
+
+	return bytes;
+}
+
+GGL::RolloutChunk GGL::RolloutChunk::Deserialize(const std::vector<uint8_t>& bytes) {
+	ByteReader reader = ByteReader(bytes);
+
+	RolloutChunk chunk = {};
+	chunk.policyVersion = reader.Read<uint64_t>();
+	chunk.stepsCollected = reader.Read<int64_t>();
+	chunk.collectionTime = reader.Read<float>();
+
+	for (auto tensor : { &chunk.states, &chunk.actionMasks, &chunk.actions, &chunk.logProbs, &chunk.rewards, &chunk.terminals, &chunk.values })
+		*tensor = reader.ReadTensor();
+	chunk.truncNextStates = reader.ReadVec<float>();
+
+	// Chunks come from other machines, so make sure they are at least consistent before anything uses them
+	int64_t numSteps = chunk.GetNumSteps();
+	for (auto tensor : { &chunk.states, &chunk.actionMasks, &chunk.actions, &chunk.logProbs, &chunk.rewards, &chunk.terminals })
+		if (!tensor->defined() || tensor->dim() == 0 || tensor->size(0) != numSteps)
+			RG_ERR_CLOSE("RolloutChunk: Received chunk has missing or mismatched tensors");
+	if (chunk.values.defined() && (chunk.values.dim() == 0 || chunk.values.size(0) != numSteps))
+		RG_ERR_CLOSE("RolloutChunk: Received chunk has mismatched critic values");
+	if (chunk.stepsCollected < 0)
+		RG_ERR_CLOSE("RolloutChunk: Received chunk has a negative step count");
+
+	return chunk;
+}
+
+std::vector<uint8_t> GGL::RolloutPolicy::Serialize() const {
+	std::vector<uint8_t> bytes = {};
+	ByteWriter writer = ByteWriter(bytes);
+
+	writer.Write(version);
+
+	writer.Write<uint32_t>(modelParams.size());
+	for (auto& pair : modelParams) {
+		writer.WriteString(pair.first);
+		writer.WriteTensor(pair.second);
+	}
+
+	writer.WriteVec(obsMean);
+	writer.WriteVec(obsSTD);
+
+	return bytes;
+}
+
+GGL::RolloutPolicy GGL::RolloutPolicy::Deserialize(const std::vector<uint8_t>& bytes) {
+	ByteReader reader = ByteReader(bytes);
+
+	RolloutPolicy policy = {};
+	policy.version = reader.Read<uint64_t>();
+
+	uint32_t numModels = reader.Read<uint32_t>();
+	for (uint32_t i = 0; i < numModels; i++) {
+		std::string name = reader.ReadString();
+		policy.modelParams[name] = reader.ReadTensor();
+	}
+
+	policy.obsMean = reader.ReadVec<double>();
+	policy.obsSTD = reader.ReadVec<double>();
+
+	return policy;
+}
+
+struct RolloutMsgHeader {
+	uint32_t type;
+	uint64_t size;
+};
+
+bool GGL::SendRolloutMsg(Socket& socket, RolloutMsgType type, const std::vector<uint8_t>& data) {
+	RolloutMsgHeader header = { (uint32_t)type, data.size() };
+	return socket.SendAll(&header, sizeof(header)) && socket.SendAll(data.data(), data.size());
+}
+
+bool GGL::RecvRolloutMsg(Socket& socket, RolloutMsgType& outType, std::vector<uint8_t>& outData) {
+	RolloutMsgHeader header;
+	if (!socket.RecvAll(&header, sizeof(header)))
+		return false;
+
+	if (header.size > ROLLOUT_MSG_MAX_SIZE)
+		return false;
+
+	outType = (RolloutMsgType)header.type;
+	outData.resize(header.size);
+	return socket.RecvAll(outData.data(), outData.size());
+}
@@ -0,0 +1,57 @@
+#pragma once
+#include "Socket.h"
+#include "../FrameworkTorch.h"
+
+namespace GGL {
+
+	// NOTE: Messages are sent in native byte order, so workers must run on machines with the same endianness as the learner
+	enum class RolloutMsgType : uint32_t {
+		POLICY = 1, // Learner -> worker
+		CHUNK = 2 // Worker -> learner
+	};
+
+	// Committed experience collected by a rollout worker
+	// Tensors are in episode order, the same as RolloutStorage::GetCommittedIndices()
+	struct RolloutChunk {
+		int workerID = -1; // Set by the server when received
+		uint64_t policyVersion = 0; // Version of the policy this was collected with
+
+		torch::Tensor states, actionMasks, actions, logProbs, rewards, terminals;
+		torch::Tensor values; // Only defined if critic values were inferred during collection
+		FList truncNextStates; // Next states of truncated episodes, in episode order
+
+		int64_t stepsCollected = 0;
+		float collectionTime = 0;
+
+		int64_t GetNumSteps() const {
+			return rewards.defined() ? rewards.size(0) : 0;
+		}
+
+		std::vector<uint8_t> Serialize() const;
+		// Throws if the message is malformed
+		static RolloutChunk Deserialize(const std::vector<uint8_t>& bytes);
+	};
+
+	// Policy weights (and obs stats) broadcast to rollout workers
+	struct RolloutPolicy {
+		uint64_t version = 0;
+
+		// Flattened parameters of each policy model, by model name
+		// Also includes the critic if values are inferred during collection
+		std::map<std::string, torch::Tensor> modelParams;
+
+		// Empty if obs standardization is off
+		std::vector<double> obsMean, obsSTD;
+
+		std::vector<uint8_t> Serialize() const;
+		// Throws if the message is malformed
+		static RolloutPolicy Deserialize(const std::vector<uint8_t>& bytes);
+	};
+
+	// Larger messages are treated as a broken connection rather than allocated
+	constexpr uint64_t ROLLOUT_MSG_MAX_SIZE = 1ull << 32;
+
+	// Sends/receives a length-prefixed message, returns false if the connection was lost
+	bool SendRolloutMsg(Socket& socket, RolloutMsgType type, const std::vector<uint8_t>& data);
+	bool RecvRolloutMsg(Socket& socket, RolloutMsgType& outType, std::vector<uint8_t>& outData);
+}
@@ -0,0 +1,231 @@
+#include "RolloutServer.h"
+
+#include <RLGymCPP/TerminalConditions/TerminalCondition.h>
+
+GGL::RolloutServer::RolloutServer(const std::string& bindAddress, int port, RolloutChunkLayout layout) :
+	bindAddress(bindAddress), port(port), layout(layout) {
+
+	RG_LOG("RolloutServer: Listening for rollout workers on " << (bindAddress.empty() ? "all interfaces" : bindAddress) << ", port " << port << "...");
+	listenSocket = Socket::Listen(bindAddress, port);
+	acceptThread = std::thread([this]() { _AcceptLoop(); });
+}
+
+int GGL::RolloutServer::GetNumWorkers() {
+	std::lock_guard<std::mutex> lock(mutex);
+
+	int count = 0;
+	for (WorkerConn* worker : workers)
+		count += worker->connected;
+	return count;
+}
+
+std::vector<GGL::RolloutChunk> GGL::RolloutServer::TakeChunks() {
+	std::lock_guard<std::mutex> lock(mutex);
+
+	std::vector<RolloutChunk> result = std::move(pendingChunks);
+	pendingChunks.clear();
+	numPendingSteps = 0;
+	return result;
+}
+
+void GGL::RolloutServer::BroadcastPolicy(const RolloutPolicy& policy) {
+	// Serialize outside the lock, it can take a while for big models
+	auto policyBytes = std::make_shared<const std::vector<uint8_t>>(policy.Serialize());
+
+	std::lock_guard<std::mutex> lock(mutex);
+	latestPolicyBytes = policyBytes;
+	for (WorkerConn* worker : workers) {
+		if (!worker->connected)
+			continue;
+
+		std::lock_guard<std::mutex> sendLock(worker->sendMutex);
+		worker->pendingPolicy = policyBytes;
+		worker->sendCV.notify_all();
+	}
+}
+
+std::string GGL::RolloutServer::_ValidateChunk(const RolloutChunk& chunk) const {
+	// RolloutChunk::Deserialize() already checked that every tensor has the same number of steps
+	int64_t numSteps = chunk.GetNumSteps();
+
+	auto fnCheck = [&](const torch::Tensor& tensor, const char* name, torch::ScalarType dtype, int64_t width) -> std::string {
+		if (tensor.scalar_type() != dtype)
+			return RS_STR(name << " have dtype " << tensor.scalar_type() << ", expected " << dtype);
+
+		std::vector<int64_t> expectedShape = { numSteps };
+		if (width > 0)
+			expectedShape.push_back(width);
+		if (tensor.sizes() != c10::IntArrayRef(expectedShape))
+			return RS_STR(name << " have shape " << tensor.sizes() << ", expected " << c10::IntArrayRef(expectedShape));
+
+		if (dtype == torch::kFloat32 && !torch::isfinite(tensor).all().item<bool>())
+			return RS_STR(name << " contain NaN/inf values");
+
+		return {};
+	};
+
+	std::string error;
+	if (
+		!(error = fnCheck(chunk.states, "States", torch::kFloat32, layout.obsSize)).empty() ||
+		!(error = fnCheck(chunk.actionMasks, "Action masks", torch::kUInt8, layout.numActions)).empty() ||
+		!(error = fnCheck(chunk.actions, "Actions", torch::kInt32, 0)).empty() ||
+		!(error = fnCheck(chunk.logProbs, "Log probs", torch::kFloat32, 0)).empty() ||
+		!(error = fnCheck(chunk.rewards, "Rewards", torch::kFloat32, 0)).empty() ||
+		!(error = fnCheck(chunk.terminals, "Terminals", torch::kInt8, 0)).empty()
+	) {
+		return error;
+	}
+
+	if (chunk.values.defined()) {
+		error = fnCheck(chunk.values, "Critic values", torch::kFloat32, 0);
+		if (!error.empty())
+			return error;
+	} else if (layout.requireValues) {
+		return "Critic values are missing, the worker must also have config.collectCriticValues enabled";
+	}
+
+	if (numSteps > 0) {
+		if (chunk.actions.min().item<int>() < 0 || chunk.actions.max().item<int>() >= layout.numActions)
+			return "Actions are out of range";
+
+		if (chunk.terminals.min().item<int8_t>() < RLGC::TerminalType::NOT_TERMINAL || chunk.terminals.max().item<int8_t>() > RLGC::TerminalType::TRUNCATED)
+			return "Terminals have invalid values";
+
+		// Chunks only contain complete episodes
+		if (chunk.terminals[-1].item<int8_t>() == RLGC::TerminalType::NOT_TERMINAL)
+			return "Last step is not terminal";
+	}
+
+	int64_t numTruncated = (chunk.terminals == RLGC::TerminalType::TRUNCATED).sum().item<int64_t>();
+	if (chunk.truncNextStates.size() != numTruncated * layout.obsSize)
+		return RS_STR("Has " << chunk.truncNextStates.size() << " truncated next state values, expected " << numTruncated << " states of size " << layout.obsSize);
+
+	for (float f : chunk.truncNextStates)
+		if (!std::isfinite(f))
+			return "Truncated next states contain NaN/inf values";
+
+	return {};
+}
+
+void GGL::RolloutServer::_ReapWorkers() {
+	std::vector<WorkerConn*> disconnected = {};
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		for (auto itr = workers.begin(); itr != workers.end();) {
+			if ((*itr)->connected) {
+				itr++;
+			} else {
+				disconnected.push_back(*itr);
+				itr = workers.erase(itr);
+			}
+		}
+	}
+
+	// Joined outside the lock, as the receive thread may be waiting on it to add a chunk
+	for (WorkerConn* worker : disconnected) {
+		worker->Disconnect();
+		if (worker->recvThread.joinable())
+			worker->recvThread.join();
+		if (worker->sendThread.joinable())
+			worker->sendThread.join();
+		delete worker;
+	}
+}
+
+void GGL::RolloutServer::_AcceptLoop() {
+	while (true) {
+		Socket clientSocket = listenSocket.Accept();
+		if (!clientSocket.IsValid())
+			break; // Listen socket was closed
+
+		// Free the workers that left, so reconnecting workers don't pile up
+		_ReapWorkers();
+
+		clientSocket.SetSendTimeout(SEND_TIMEOUT_MS);
+
+		std::lock_guard<std::mutex> lock(mutex);
+
+		WorkerConn* worker = new WorkerConn();
+		worker->id = nextWorkerID++;
+		worker->socket = std::move(clientSocket);
+
+		// The send thread sends the current policy right away, so the worker can start collecting
+		worker->pendingPolicy = latestPolicyBytes;
+
+		workers.push_back(worker);
+		RG_LOG("RolloutServer: Worker " << worker->id << " connected");
+
+		worker->recvThread = std::thread([this, worker]() { _RecvLoop(worker); });
+		worker->sendThread = std::thread([this, worker]() { _SendLoop(worker); });
+	}
+}
+
+void GGL::RolloutServer::_RecvLoop(WorkerConn* worker) {
+	RolloutMsgType msgType;
+	std::vector<uint8_t> msgData;
+	while (worker->connected && RecvRolloutMsg(worker->socket, msgType, msgData)) {
+		if (msgType != RolloutMsgType::CHUNK) {
+			RG_LOG("RolloutServer: Worker " << worker->id << " sent an unexpected message (type " << (int)msgType << "), disconnecting");
+			break;
+		}
+
+		// A bad message only costs us this worker, it shouldn't take down the learner
+		RolloutChunk chunk;
+		try {
+			chunk = RolloutChunk::Deserialize(msgData);
+		} catch (std::exception& e) {
+			RG_LOG("RolloutServer: Worker " << worker->id << " sent a malformed chunk, disconnecting (" << e.what() << ")");
+			break;
+		}
+		chunk.workerID = worker->id;
+
+		std::string error = _ValidateChunk(chunk);
+		if (!error.empty()) {
+			// A worker with a different setup would send nothing but bad chunks
+			RG_LOG("RolloutServer: Worker " << worker->id << " sent a chunk that doesn't match the learner, discarding it and disconnecting (" << error << ")");
+			break;
+		}
+
+		std::lock_guard<std::mutex> lock(mutex);
+		numPendingSteps += chunk.GetNumSteps();
+		pendingChunks.push_back(std::move(chunk));
+	}
+
+	if (worker->connected)
+		RG_LOG("RolloutServer: Worker " << worker->id << " disconnected");
+	worker->Disconnect();
+}
+
+void GGL::RolloutServer::_SendLoop(WorkerConn* worker) {
+	while (true) {
+		std::shared_ptr<const std::vector<uint8_t>> policyBytes;
+		{
+			std::unique_lock<std::mutex> lock(worker->sendMutex);
+			worker->sendCV.wait(lock, [worker] { return !worker->connected || worker->pendingPolicy; });
+			if (!worker->connected)
+				break;
+
+			policyBytes = std::move(worker->pendingPolicy);
+			worker->pendingPolicy = NULL;
+		}
+
+		// Fails if the worker doesn't read it within the send timeout
+		if (!SendRolloutMsg(worker->socket, RolloutMsgType::POLICY, *policyBytes)) {
+			if (worker->connected)
+				RG_LOG("RolloutServer: Lost connection to worker " << worker->id << " while sending policy");
+			worker->Disconnect();
+			break;
+		}
+	}
+}
+
+GGL::RolloutServer::~RolloutServer() {
+	listenSocket.Shutdown();
+	listenSocket.Close();
+	if (acceptThread.joinable())
+		acceptThread.join();
+
+	for (WorkerConn* worker : workers)
+		worker->connected = false;
+	_ReapWorkers();
+}
@@ -0,0 +1,82 @@
+#pragma once
+#include "RolloutMessages.h"
+
+namespace GGL {
+
+	// What chunks must look like to be learned from, chunks that don't match are discarded
+	struct RolloutChunkLayout {
+		int obsSize;
+		int numActions;
+		bool requireValues; // Critic values must be included (if the learner uses config.collectCriticValues)
+	};
+
+	// Runs on the learner, receives experience chunks from rollout workers and sends them new policies
+	// Each worker has its own receive and send threads, so a slow or stalled worker never blocks the learner
+	class RolloutServer {
+	public:
+		// A worker that doesn't take a policy for this long is disconnected
+		static constexpr int SEND_TIMEOUT_MS = 30 * 1000;
+
+		struct WorkerConn {
+			int id;
+			Socket socket;
+			std::thread recvThread, sendThread;
+			std::atomic<bool> connected = true;
+
+			std::mutex sendMutex; // Guards pendingPolicy
+			std::condition_variable sendCV;
+			std::shared_ptr<const std::vector<uint8_t>> pendingPolicy; // Newest policy not yet sent, older ones are skipped
+
+			// Wakes the send thread, which exits once it sees the worker is disconnected
+			void Disconnect() {
+				connected = false;
+				socket.Shutdown();
+				std::lock_guard<std::mutex> lock(sendMutex);
+				sendCV.notify_all();
+			}
+		};
+
+		std::string bindAddress;
+		int port;
+		RolloutChunkLayout layout;
+		Socket listenSocket;
+		std::thread acceptThread;
+
+		std::mutex mutex; // Guards everything below
+		std::vector<WorkerConn*> workers;
+		int nextWorkerID = 0;
+		std::vector<RolloutChunk> pendingChunks;
+		std::shared_ptr<const std::vector<uint8_t>> latestPolicyBytes; // Sent to workers as soon as they connect
+
+		std::atomic<int64_t> numPendingSteps = 0;
+
+		RolloutServer(const std::string& bindAddress, int port, RolloutChunkLayout layout);
+		RG_NO_COPY(RolloutServer);
+
+		// Total steps in all chunks that haven't been taken yet
+		int64_t GetNumPendingSteps() const {
+			return numPendingSteps;
+		}
+
+		int GetNumWorkers();
+
+		// Removes and returns all received chunks
+		std::vector<RolloutChunk> TakeChunks();
+
+		// Queues the policy to be sent to all connected workers, and to any that connect later
+		// Doesn't block on the workers
+		void BroadcastPolicy(const RolloutPolicy& policy);
+
+		~RolloutServer();
+
+		// Returns an empty string if the chunk matches the layout
+		std::string _ValidateChunk(const RolloutChunk& chunk) const;
+
+		// Joins and frees disconnected workers
+		void _ReapWorkers();
+
+		void _AcceptLoop();
+		void _RecvLoop(WorkerConn* worker);
+		void _SendLoop(WorkerConn* worker);
+	};
+}
@@ -0,0 +1,183 @@
+#include "Socket.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#pragma comment(lib, "ws2_32.lib")
+
+typedef int socklen_t;
+#define RG_CLOSE_SOCKET closesocket
+#define RG_SHUT_BOTH SD_BOTH
+#define RG_SEND_FLAGS 0
+#else
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <netdb.h>
+#include <unistd.h>
+
+#define RG_CLOSE_SOCKET close
+#define RG_SHUT_BOTH SHUT_RDWR
+// Without this, sending to a peer that has disconnected raises SIGPIPE and kills the process instead of failing
+#ifdef MSG_NOSIGNAL
+#define RG_SEND_FLAGS MSG_NOSIGNAL
+#else
+#define RG_SEND_FLAGS 0
+#endif
+#endif
+
+namespace {
+	void InitSockets() {
+#ifdef _WIN32
+		static std::once_flag initFlag;
+		std::call_once(initFlag, []() {
+			WSADATA wsaData;
+			if (WSAStartup(MAKEWORD(2, 2), &wsaData) != 0)
+				RG_ERR_CLOSE("Socket: WSAStartup() failed");
+		});
+#endif
+	}
+
+	void SetNoDelay(GGL::Socket::Handle handle) {
+		// We send whole messages at once, so there's nothing to gain from Nagle's algorithm
+		int flag = 1;
+		setsockopt(handle, IPPROTO_TCP, TCP_NODELAY, (const char*)&flag, sizeof(flag));
+
+#ifdef SO_NOSIGPIPE
+		// Platforms without MSG_NOSIGNAL (macOS) need this to avoid SIGPIPE on a lost connection
+		setsockopt(handle, SOL_SOCKET, SO_NOSIGPIPE, (const char*)&flag, sizeof(flag));
+#endif
+	}
+}
+
+GGL::Socket GGL::Socket::Connect(const std::string& host, int port) {
+	InitSockets();
+
+	addrinfo hints = {};
+	hints.ai_family = AF_UNSPEC;
+	hints.ai_socktype = SOCK_STREAM;
+	hints.ai_protocol = IPPROTO_TCP;
+
+	addrinfo* results = NULL;
+	if (getaddrinfo(host.c_str(), std::to_string(port).c_str(), &hints, &results) != 0)
+		return Socket();
+
+	Socket result = {};
+	for (addrinfo* cur = results; cur; cur = cur->ai_next) {
+		Handle handle = (Handle)socket(cur->ai_family, cur->ai_socktype, cur->ai_protocol);
+		if (handle == INVALID_HANDLE)
+			continue;
+
+		if (connect(handle, cur->ai_addr, (socklen_t)cur->ai_addrlen) == 0) {
+			SetNoDelay(handle);
+			result = Socket(handle);
+			break;
+		}
+
+		RG_CLOSE_SOCKET(handle);
+	}
+
+	freeaddrinfo(results);
+	return result;
+}
+
+GGL::Socket GGL::Socket::Listen(const std::string& host, int port) {
+	InitSockets();
+
+	constexpr const char* ERROR_PREFIX = "Socket::Listen(): ";
+
+	addrinfo hints = {};
+	hints.ai_family = AF_UNSPEC;
+	hints.ai_socktype = SOCK_STREAM;
+	hints.ai_protocol = IPPROTO_TCP;
+	hints.ai_flags = AI_PASSIVE;
+
+	addrinfo* results = NULL;
+	if (getaddrinfo(host.empty() ? NULL : host.c_str(), std::to_string(port).c_str(), &hints, &results) != 0 || !results)
+		RG_ERR_CLOSE(ERROR_PREFIX << "Failed to resolve bind address \"" << host << "\"");
+
+	Handle handle = (Handle)socket(results->ai_family, results->ai_socktype, results->ai_protocol);
+	if (handle == INVALID_HANDLE) {
+		freeaddrinfo(results);
+		RG_ERR_CLOSE(ERROR_PREFIX << "Failed to create socket");
+	}
+
+	int reuse = 1;
+	setsockopt(handle, SOL_SOCKET, SO_REUSEADDR, (const char*)&reuse, sizeof(reuse));
+
+	bool bound = bind(handle, results->ai_addr, (socklen_t)results->ai_addrlen) == 0;
+	freeaddrinfo(results);
+	if (!bound) {
+		RG_CLOSE_SOCKET(handle);
+		RG_ERR_CLOSE(ERROR_PREFIX << "Failed to bind to " << host << ":" << port);
+	}
+
+	if (listen(handle, SOMAXCONN) != 0) {
+		RG_CLOSE_SOCKET(handle);
+		RG_ERR_CLOSE(ERROR_PREFIX << "Failed to listen on port " << port);
+	}
+
+	return Socket(handle);
+}
+
+GGL::Socket GGL::Socket::Accept() {
+	Handle clientHandle = (Handle)accept(handle, NULL, NULL);
+	if (clientHandle == INVALID_HANDLE)
+		return Socket();
+
+	SetNoDelay(clientHandle);
+	return Socket(clientHandle);
+}
+
+void GGL::Socket::SetSendTimeout(int timeoutMS) {
+#ifdef _WIN32
+	DWORD timeout = timeoutMS;
+#else
+	timeval timeout = {};
+	timeout.tv_sec = timeoutMS / 1000;
+	timeout.tv_usec = (timeoutMS % 1000) * 1000;
+#endif
+	setsockopt(handle, SOL_SOCKET, SO_SNDTIMEO, (const char*)&timeout, sizeof(timeout));
+}
+
+bool GGL::Socket::SendAll(const void* data, size_t size) {
+	const char* cur = (const char*)data;
+	while (size > 0) {
+		int chunkSize = (int)RS_MIN(size, (size_t)(1 << 30));
+		int sent = send(handle, cur, chunkSize, RG_SEND_FLAGS);
+		if (sent <= 0)
+			return false;
+
+		cur += sent;
+		size -= sent;
+	}
+	return true;
+}
+
+bool GGL::Socket::RecvAll(void* data, size_t size) {
+	char* cur = (char*)data;
+	while (size > 0) {
+		int chunkSize = (int)RS_MIN(size, (size_t)(1 << 30));
+		int received = recv(handle, cur, chunkSize, 0);
+		if (received <= 0)
+			return false;
+
+		cur += received;
+		size -= received;
+	}
+	return true;
+}
+
+void GGL::Socket::Shutdown() {
+	if (IsValid())
+		shutdown(handle, RG_SHUT_BOTH);
+}
+
+void GGL::Socket::Close() {
+	if (IsValid()) {
+		RG_CLOSE_SOCKET(handle);
+		handle = INVALID_HANDLE;
+	}
+}
@@ -0,0 +1,65 @@
+#pragma once
+#include <GigaLearnCPP/Framework.h>
+#include <atomic>
+#include <condition_variable>
+
+namespace GGL {
+
+	// Minimal blocking TCP socket, works with both Winsock and POSIX sockets
+	class Socket {
+	public:
+#ifdef _WIN32
+		typedef uintptr_t Handle;
+#else
+		typedef int Handle;
+#endif
+		static constexpr Handle INVALID_HANDLE = (Handle)-1;
+
+		Handle handle = INVALID_HANDLE;
+
+		Socket() = default;
+		explicit Socket(Handle handle) : handle(handle) {}
+
+		RG_NO_COPY(Socket);
+
+		Socket(Socket&& other) noexcept : handle(other.handle) {
+			other.handle = INVALID_HANDLE;
+		}
+
+		Socket& operator=(Socket&& other) noexcept {
+			Close();
+			handle = other.handle;
+			other.handle = INVALID_HANDLE;
+			return *this;
+		}
+
+		~Socket() {
+			Close();
+		}
+
+		bool IsValid() const {
+			return handle != INVALID_HANDLE;
+		}
+
+		// Returns an invalid socket on failure
+		static Socket Connect(const std::string& host, int port);
+
+		// Binds and listens on the given address (empty for all interfaces), throws on failure
+		static Socket Listen(const std::string& host, int port);
+
+		// Blocks until a connection is made, returns an invalid socket on failure
+		Socket Accept();
+
+		// Makes sends that block for longer than this fail, so a peer that stops reading counts as a lost connection
+		void SetSendTimeout(int timeoutMS);
+
+		// Returns false if the connection was lost
+		bool SendAll(const void* data, size_t size);
+		bool RecvAll(void* data, size_t size);
+
+		// Unblocks any threads waiting on this socket
+		void Shutdown();
+
+		void Close();
+	};
+}
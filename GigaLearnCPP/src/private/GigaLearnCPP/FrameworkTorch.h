@@ -9,23 +9,52 @@
 
 #define RG_NO_GRAD torch::NoGradGuard _noGradGuard
 
-#define RG_AUTOCAST_ON() { \
-at::autocast::set_enabled(true); \
-at::autocast::set_autocast_gpu_dtype(torch::kBFloat16); \
-at::autocast::set_autocast_cpu_dtype(torch::kFloat); \
-}
-
-#define RG_AUTOCAST_OFF() { \
-at::autocast::clear_cache(); \
-at::autocast::set_enabled(false); \
-}
-
 #define RG_HALFPERC_TYPE torch::ScalarType::BFloat16
 
+// Runs eligible ops (matmuls etc.) on the device type in RG_HALFPERC_TYPE until the scope ends, parameters are left as-is
+// Autocast state is per-thread
+#define RG_AUTOCAST(deviceType) GGL::AutocastGuard _autocastGuard(deviceType)
+
 namespace GGL {
+	struct AutocastGuard {
+		at::DeviceType deviceType;
+		bool prevEnabled;
+		at::ScalarType prevDType;
+
+		AutocastGuard(at::DeviceType deviceType) : deviceType(deviceType) {
+			prevEnabled = at::autocast::is_autocast_enabled(deviceType);
+			prevDType = at::autocast::get_autocast_dtype(deviceType);
+			at::autocast::set_autocast_enabled(deviceType, true);
+			at::autocast::set_autocast_dtype(deviceType, RG_HALFPERC_TYPE);
+			at::autocast::increment_nesting();
+		}
+
+		~AutocastGuard() {
+			// Cached casts of the parameters would be stale after the next optimizer step
+			if (at::autocast::decrement_nesting() == 0)
+				at::autocast::clear_cache();
+			at::autocast::set_autocast_enabled(deviceType, prevEnabled);
+			at::autocast::set_autocast_dtype(deviceType, prevDType);
+		}
+
+		RG_NO_COPY(AutocastGuard);
+	};
+
+	// NOTE: This is a view of the list's memory, not a copy
+	//	It is only valid until the list is resized or destroyed, and will reflect any changes made to the list
+	//	Clone it if you need to keep it around
 	template <typename T>
 	inline torch::Tensor DIMLIST2_TO_TENSOR(const RLGC::DimList2<T>& list) {
-		return torch::tensor(list.data).reshape({ (int64_t)list.size[0], (int64_t)list.size[1] });
+		return torch::from_blob(
+			const_cast<T*>(list.data.data()),
+			{ (int64_t)list.size[0], (int64_t)list.size[1] },
+			torch::TensorOptions().dtype(torch::CppTypeToScalarType<T>::value)
+		);
+	}
+
+	// Bytes held by the tensor's storage (which is shared by all of its views), or 0 if undefined
+	inline uint64_t GetTensorMemoryUsage(const torch::Tensor& tensor) {
+		return tensor.defined() ? tensor.storage().nbytes() : 0;
 	}
 
 	template <typename T>
@@ -35,4 +64,13 @@ namespace GGL {
 		T* data = tensor.data_ptr<T>();
 		return std::vector<T>(data, data + tensor.size(0));
 	}
+
+	// Same as above, but reuses the output vector's storage
+	template <typename T>
+	inline void TENSOR_TO_VEC(torch::Tensor tensor, std::vector<T>& out) {
+		assert(tensor.dim() == 1);
+		tensor = tensor.contiguous().cpu().detach().to(torch::CppTypeToScalarType<T>());
+		T* data = tensor.data_ptr<T>();
+		out.assign(data, data + tensor.size(0));
+	}
 }
\ No newline at end of file
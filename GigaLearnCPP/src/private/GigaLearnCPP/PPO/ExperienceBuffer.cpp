@@ -7,51 +7,106 @@ GGL::ExperienceBuffer::ExperienceBuffer(int seed, torch::Device device) :
 
 }
 
-GGL::ExperienceTensors GGL::ExperienceBuffer::_GetSamples(const int64_t* indices, size_t size) const {
-
-	// TODO: Slow, use blob
-	Tensor tIndices = torch::tensor(IList(indices, indices + size));
-
+GGL::ExperienceTensors GGL::ExperienceBuffer::_GetSamples(const torch::Tensor& sampleIndices) const {
 	ExperienceTensors result;
-	auto fnSlice = [=](torch::Tensor t) -> torch::Tensor {
-		return torch::index_select(t, 0, tIndices);
-	};
 
 	auto* toItr = result.begin();
 	auto* fromItr = data.begin();
 	for (; toItr != result.end(); toItr++, fromItr++)
-		*toItr = torch::index_select(*fromItr, 0, tIndices);
+		*toItr = torch::index_select(*fromItr, 0, sampleIndices);
 
 	return result;
 }
 
-std::vector<GGL::ExperienceTensors> GGL::ExperienceBuffer::GetAllBatchesShuffled(int64_t batchSize, bool overbatching) {
+void GGL::ExperienceBuffer::_PermuteIntoScratch() {
+	int64_t expSize = _shuffledIndices.size(0);
+
+	auto* toItr = scratch.begin();
+	auto* fromItr = data.begin();
+	for (; toItr != scratch.end(); toItr++, fromItr++) {
+		torch::Tensor& buffer = *toItr;
+		const torch::Tensor& from = *fromItr;
+
+		// Reallocate if this tensor changed or outgrew the buffer
+		// Some extra room is added, since the amount of experience varies a bit every iteration
+		bool fits =
+			buffer.defined() && buffer.size(0) >= expSize &&
+			buffer.dtype() == from.dtype() && buffer.sizes().slice(1) == from.sizes().slice(1);
+		if (!fits) {
+			auto sizes = from.sizes().vec();
+			sizes[0] = expSize + expSize / 8;
+			buffer = torch::Tensor(); // Free the old buffer first
+			buffer = torch::empty(sizes, from.options());
+		}
+
+		// index_select is parallelized over rows by torch's own threads
+		auto out = buffer.slice(0, 0, expSize);
+		torch::index_select_out(out, from, 0, _shuffledIndices);
+	}
+}
+
+int GGL::ExperienceBuffer::BeginEpoch(int64_t batchSize, bool overbatching) {
 
 	RG_NO_GRAD;
 
-	size_t expSize = data.states.size(0);
+	int64_t expSize = this->indices.defined() ? this->indices.size(0) : data.states.size(0);
 
 	// Make list of shuffled sample indices
-	int64_t* indices = new int64_t[expSize];
-	std::iota(indices, indices + expSize, 0); // Fill ascending indices
-	std::shuffle(indices, indices + expSize, rng);
+	if (this->indices.defined()) {
+		_shuffledIndices = this->indices.to(torch::kInt64).contiguous().clone();
+	} else {
+		_shuffledIndices = torch::arange(expSize, torch::kInt64);
+	}
+	int64_t* indicesPtr = _shuffledIndices.data_ptr<int64_t>();
+	std::shuffle(indicesPtr, indicesPtr + expSize, rng);
 
-	// Get a sample set from each of the batches
-	std::vector<ExperienceTensors> result;
+	_batchStarts.clear();
 	for (int64_t startIdx = 0; startIdx + batchSize <= expSize; startIdx += batchSize) {
+		_batchStarts.push_back(startIdx);
 
-		int curBatchSize = batchSize;
 		if (startIdx + batchSize * 2 > expSize) {
 			// Last batch of the iteration
 			if (overbatching) {
 				// Extend batch size to the end of the experience
-				curBatchSize = expSize - startIdx;
+				_batchStarts.push_back(expSize);
+			} else {
+				_batchStarts.push_back(startIdx + batchSize);
 			}
 		}
+	}
+	int numBatches = RS_MAX((int)_batchStarts.size() - 1, 0);
 
-		result.push_back(_GetSamples(indices + startIdx, curBatchSize));
+	if (!lazyBatches && numBatches > 0) {
+		_PermuteIntoScratch();
+	} else {
+		// Don't keep the old epoch's copy around
+		scratch = {};
 	}
 
-	delete[] indices;
+	return numBatches;
+}
+
+GGL::ExperienceTensors GGL::ExperienceBuffer::GetBatch(int batchIdx) const {
+	RG_ASSERT(batchIdx >= 0 && batchIdx < (int)_batchStarts.size() - 1);
+	int64_t start = _batchStarts[batchIdx], stop = _batchStarts[batchIdx + 1];
+
+	if (lazyBatches)
+		return _GetSamples(_shuffledIndices.slice(0, start, stop));
+
+	ExperienceTensors result;
+	auto* toItr = result.begin();
+	auto* fromItr = scratch.begin();
+	for (; toItr != result.end(); toItr++, fromItr++)
+		*toItr = fromItr->slice(0, start, stop);
+
 	return result;
-}
\ No newline at end of file
+}
+
+std::vector<GGL::ExperienceTensors> GGL::ExperienceBuffer::GetAllBatchesShuffled(int64_t batchSize, bool overbatching) {
+	int numBatches = BeginEpoch(batchSize, overbatching);
+
+	std::vector<ExperienceTensors> result;
+	for (int i = 0; i < numBatches; i++)
+		result.push_back(GetBatch(i));
+	return result;
+}
@@ -22,13 +22,38 @@ namespace GGL {
 
 		ExperienceTensors data;
 
+		// Optional, if defined, only these rows of data are sampled from
+		// This allows data to be a view of storage that contains other stuff
+		torch::Tensor indices;
+
+		// If true, each batch is gathered from data when it is requested, instead of permuting all of data at the start of the epoch
+		// Saves the memory of a second copy of the experience, but batches are no longer views of one contiguous buffer
+		bool lazyBatches = false;
+
+		// Data in the shuffled order of the current epoch, only used if !lazyBatches
+		// Reused between epochs and iterations, and only reallocated when the experience outgrows it
+		ExperienceTensors scratch;
+
 		std::default_random_engine rng;
 
 		ExperienceBuffer(int seed, torch::Device device);
 
-		ExperienceTensors _GetSamples(const int64_t* indices, size_t size) const;
+		// Shuffles the experience for a new epoch and returns the number of batches
+		// Unless lazyBatches, this permutes every tensor of data into scratch
+		int BeginEpoch(int64_t batchSize, bool overbatching);
+
+		// Returns a batch of the current epoch
+		// Unless lazyBatches, this is a zero-copy view of scratch, and is only valid until the next BeginEpoch()
+		ExperienceTensors GetBatch(int batchIdx) const;
 
 		// Not const because it uses our random engine
+		// Same as calling GetBatch() for every batch after BeginEpoch()
 		std::vector<ExperienceTensors> GetAllBatchesShuffled(int64_t batchSize, bool overbatching);
+
+		ExperienceTensors _GetSamples(const torch::Tensor& sampleIndices) const;
+		void _PermuteIntoScratch();
+
+		torch::Tensor _shuffledIndices; // Rows of data in the order of the current epoch
+		std::vector<int64_t> _batchStarts; // Includes the end of the last batch
 	};
-}
\ No newline at end of file
+}
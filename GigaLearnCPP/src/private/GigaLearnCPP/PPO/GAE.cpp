@@ -74,7 +74,8 @@ void GGL::GAE::Compute(
 			if (truncCount >= numTruncs)
 				RG_ERR_CLOSE("GAE encountered too many truncated terminals, not enough val preds (max: " << numTruncs << ")")
 
-			nextValPred = _truncValPreds[truncCount];
+			// Truncations are in forward order, but we are iterating backwards
+			nextValPred = _truncValPreds[numTruncs - 1 - truncCount];
 			truncCount++;
 		} else {
 			nextValPred = _valPreds[step + 1];
@@ -99,4 +100,48 @@ void GGL::GAE::Compute(
 	outAdvantages = torch::tensor(_outAdvantages);
 	outTargetValues = valPreds.slice(0, 0, numReturns) + outAdvantages;
 	outRewClipPortion = (totalRew - totalClippedRew) / RS_MAX(totalRew, 1e-7f);
-}
\ No newline at end of file
+}
+
+void GGL::GAE::ComputeEpisode(
+	const float* rews, const int8_t* terminals, const float* valPreds, int64_t length, float truncValPred,
+	float* outAdvantages, float* outReturns, float& outTotalRew, float& outTotalClippedRew,
+	float gamma, float lambda, float returnStd, float clipRange
+) {
+	float prevLambda = 0;
+	float prevRet = 0;
+
+	for (int64_t step = length - 1; step >= 0; step--) {
+		int8_t terminal = terminals[step];
+		float done = terminal == RLGC::TerminalType::NORMAL;
+		float trunc = terminal == RLGC::TerminalType::TRUNCATED;
+
+		float curReward;
+		if (returnStd != 0) {
+			curReward = rews[step] / returnStd;
+
+			outTotalRew += abs(curReward);
+
+			// We only clip if returns are standardized
+			if (clipRange > 0)
+				curReward = RS_CLAMP(curReward, -clipRange, clipRange);
+
+			outTotalClippedRew += abs(curReward);
+		} else {
+			curReward = rews[step];
+			outTotalRew += abs(curReward);
+		}
+
+		// Only the last step of an episode can be terminal
+		float nextValPred = (step == length - 1) ? (trunc ? truncValPred : 0) : valPreds[step + 1];
+
+		float predReturn = curReward + gamma * nextValPred * (1 - done);
+		float delta = predReturn - valPreds[step];
+		float curReturn = rews[step] + prevRet * gamma * (1 - done) * (1 - trunc);
+		outReturns[step] = curReturn;
+
+		prevLambda = delta + gamma * lambda * (1 - done) * (1 - trunc) * prevLambda;
+		outAdvantages[step] = prevLambda;
+
+		prevRet = curReturn;
+	}
+}
@@ -10,5 +10,14 @@ namespace GGL {
 			torch::Tensor& outAdvantages, torch::Tensor& outValues, torch::Tensor& outReturns, float& outRewClipPortion,
 			float gamma = 0.99f, float lambda = 0.95f, float returnStd = 0, float clipRange = 10
 		);
+
+		// Computes GAE for a single complete episode, straight from/to raw buffers
+		// If the episode was truncated, truncValPred is the critic's prediction for the state after its last step
+		// Absolute reward totals (before and after clipping) are added to outTotalRew and outTotalClippedRew
+		void ComputeEpisode(
+			const float* rews, const int8_t* terminals, const float* valPreds, int64_t length, float truncValPred,
+			float* outAdvantages, float* outReturns, float& outTotalRew, float& outTotalClippedRew,
+			float gamma, float lambda, float returnStd, float clipRange
+		);
 	}
 }
\ No newline at end of file
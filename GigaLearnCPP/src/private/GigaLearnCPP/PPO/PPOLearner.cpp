@@ -4,6 +4,7 @@
 #include <torch/nn/utils/clip_grad.h>
 #include <torch/csrc/api/include/torch/serialize.h>
 #include <public/GigaLearnCPP/Util/AvgTracker.h>
+#include <RLGymCPP/Tracer.h>
 
 using namespace torch;
 
@@ -90,14 +91,7 @@ torch::Tensor GGL::PPOLearner::InferPolicyProbsFromModels(
 	return result.view({ -1, models["policy"]->config.numOutputs }).clamp(ACTION_MIN_PROB, 1);
 }
 
-void GGL::PPOLearner::InferActionsFromModels(
-	ModelSet& models,
-	torch::Tensor obs, torch::Tensor actionMasks, 
-	bool deterministic, float temperature, bool halfPrec,
-	torch::Tensor* outActions, torch::Tensor* outLogProbs) {
-
-	auto probs = InferPolicyProbsFromModels(models, obs, actionMasks, temperature, halfPrec);
-
+void GGL::PPOLearner::SampleActionsFromProbs(torch::Tensor probs, bool deterministic, torch::Tensor* outActions, torch::Tensor* outLogProbs) {
 	if (deterministic) {
 		auto action = probs.argmax(1);
 		if (outActions)
@@ -113,16 +107,68 @@ void GGL::PPOLearner::InferActionsFromModels(
 	}
 }
 
+void GGL::PPOLearner::InferActionsFromModels(
+	ModelSet& models,
+	torch::Tensor obs, torch::Tensor actionMasks, 
+	bool deterministic, float temperature, bool halfPrec,
+	torch::Tensor* outActions, torch::Tensor* outLogProbs) {
+
+	auto probs = InferPolicyProbsFromModels(models, obs, actionMasks, temperature, halfPrec);
+	SampleActionsFromProbs(probs, deterministic, outActions, outLogProbs);
+}
+
+void GGL::PPOLearner::ForwardActorCritic(
+	ModelSet& models,
+	torch::Tensor obs, torch::Tensor actionMasks,
+	float temperature, bool halfPrec,
+	torch::Tensor* outProbs, torch::Tensor* outValues) {
+
+	ModelSet headModels = models; // Policy and critic only
+	if (models["shared_head"]) {
+		obs = models["shared_head"]->Forward(obs, halfPrec);
+		headModels.map.erase("shared_head");
+	}
+
+	if (outValues) {
+		RG_ASSERT(models["critic"]);
+		*outValues = models["critic"]->Forward(obs, halfPrec).flatten();
+	}
+
+	if (outProbs)
+		*outProbs = InferPolicyProbsFromModels(headModels, obs, actionMasks, temperature, halfPrec);
+}
+
 void GGL::PPOLearner::InferActions(torch::Tensor obs, torch::Tensor actionMasks, torch::Tensor* outActions, torch::Tensor* outLogProbs, ModelSet* models) {
 	InferActionsFromModels(models ? *models : this->models, obs, actionMasks, config.deterministic, config.policyTemperature, config.useHalfPrecision, outActions, outLogProbs);
 }
 
-torch::Tensor GGL::PPOLearner::InferCritic(torch::Tensor obs) {
+torch::Tensor GGL::PPOLearner::InferCritic(torch::Tensor obs, ModelSet* models) {
+	ModelSet& inferModels = models ? *models : this->models;
 
-	if (models["shared_head"])
-		obs = models["shared_head"]->Forward(obs, config.useHalfPrecision);
+	if (inferModels["shared_head"])
+		obs = inferModels["shared_head"]->Forward(obs, config.useHalfPrecision);
+
+	return inferModels["critic"]->Forward(obs, config.useHalfPrecision).flatten();
+}
+
+void GGL::PPOLearner::InferActionsAndValues(
+	torch::Tensor obs, torch::Tensor actionMasks,
+	torch::Tensor* outActions, torch::Tensor* outLogProbs, torch::Tensor* outValues,
+	ModelSet* models) {
+
+	torch::Tensor probs;
+	ForwardActorCritic(models ? *models : this->models, obs, actionMasks, config.policyTemperature, config.useHalfPrecision, &probs, outValues);
+	SampleActionsFromProbs(probs, config.deterministic, outActions, outLogProbs);
+}
+
+void GGL::PPOLearner::InferLogProbsAndValues(
+	torch::Tensor obs, torch::Tensor actionMasks, torch::Tensor actions,
+	torch::Tensor* outLogProbs, torch::Tensor* outValues,
+	ModelSet* models) {
 
-	return models["critic"]->Forward(obs, config.useHalfPrecision).flatten();
+	torch::Tensor probs;
+	ForwardActorCritic(models ? *models : this->models, obs, actionMasks, config.policyTemperature, config.useHalfPrecision, &probs, outValues);
+	*outLogProbs = torch::log(probs).gather(-1, actions.to(torch::kInt64).view({ -1, 1 })).flatten();
 }
 
 torch::Tensor ComputeEntropy(torch::Tensor probs, torch::Tensor actionMasks, bool maskEntropy) {
@@ -141,19 +187,68 @@ torch::Tensor ComputeEntropy(torch::Tensor probs, torch::Tensor actionMasks, boo
 	return entropy.mean();
 }
 
-void GGL::PPOLearner::Learn(ExperienceBuffer& experience, Report& report, bool isFirstIteration) {
-	auto mseLoss = torch::nn::MSELoss();
+// Averages scalar tensors without leaving the device, so nothing has to wait for the device until the average is read
+struct DeviceAvgTracker {
+	torch::Tensor total;
+	int count = 0;
 
-	MutAvgTracker
+	void Add(torch::Tensor val) {
+		val = val.detach().to(torch::kFloat32);
+		total = total.defined() ? (total + val) : val;
+		count++;
+	}
+
+	void Merge(const DeviceAvgTracker& other) {
+		if (other.count == 0)
+			return;
+		total = total.defined() ? (total + other.total) : other.total;
+		count += other.count;
+	}
+
+	// Zero if nothing was added
+	torch::Tensor Get(torch::Device device) const {
+		return (count > 0) ? (total / count) : torch::zeros({}, torch::TensorOptions(device).dtype(torch::kFloat32));
+	}
+};
+
+struct LearnStats {
+	DeviceAvgTracker
 		avgEntropy,
 		avgDivergence,
 		avgPolicyLoss,
 		avgRelEntropyLoss,
 		avgCriticLoss,
 		avgGuidingLoss,
-		avgRatio,
 		avgClip;
 
+	void Merge(const LearnStats& other) {
+		avgEntropy.Merge(other.avgEntropy);
+		avgDivergence.Merge(other.avgDivergence);
+		avgPolicyLoss.Merge(other.avgPolicyLoss);
+		avgRelEntropyLoss.Merge(other.avgRelEntropyLoss);
+		avgCriticLoss.Merge(other.avgCriticLoss);
+		avgGuidingLoss.Merge(other.avgGuidingLoss);
+		avgClip.Merge(other.avgClip);
+	}
+};
+
+void GGL::PPOLearner::Learn(ExperienceBuffer& experience, Report& report, bool isFirstIteration) {
+	auto mseLoss = torch::nn::MSELoss();
+
+	// CPU data-parallel learning runs minibatches on every thread at once, each with its own copy of the models
+	// The first thread uses the real models, and the gradients of the others are added to them before each optimizer step
+	int numThreads = device.is_cpu() ? RS_MAX(config.cpuLearnThreads, 1) : 1;
+	while (cpuReplicas.size() < numThreads - 1)
+		cpuReplicas.push_back(models.CloneAll());
+	for (int i = 0; i < numThreads - 1; i++)
+		cpuReplicas[i].CopyParamsFrom(models);
+	if (numThreads > 1 && (!learnThreadPool || learnThreadPool->GetNumThreads() != numThreads - 1))
+		learnThreadPool = std::make_unique<RLGC::ThreadPool>(numThreads - 1);
+
+	// Stats stay on the device and are read back together at the end, so minibatches never wait on a sync
+	// Each thread has its own stats, which are merged at the end
+	auto threadStats = std::vector<LearnStats>(numThreads);
+
 	// Save parameters first
 	auto policyBefore = models["policy"]->CopyParams();
 	auto criticBefore = models["critic"]->CopyParams();
@@ -163,11 +258,17 @@ void GGL::PPOLearner::Learn(ExperienceBuffer& experience, Report& report, bool i
 	bool trainSharedHead = models["shared_head"] && (trainPolicy || trainCritic);
 
 	for (int epoch = 0; epoch < config.epochs; epoch++) {
+		RG_TRACE_SCOPE("PPO Epoch", epoch);
 
 		// Get randomly-ordered timesteps for PPO
-		auto batches = experience.GetAllBatchesShuffled(config.batchSize, config.overbatching);
+		int numBatches;
+		{
+			RG_TRACE_SCOPE("PPO Shuffle");
+			numBatches = experience.BeginEpoch(config.batchSize, config.overbatching);
+		}
 
-		for (auto& batch : batches) {
+		for (int batchIdx = 0; batchIdx < numBatches; batchIdx++) {
+			auto batch = experience.GetBatch(batchIdx);
 			auto batchActs = batch.actions;
 			auto batchOldProbs = batch.logProbs;
 			auto batchObs = batch.states;
@@ -175,7 +276,8 @@ void GGL::PPOLearner::Learn(ExperienceBuffer& experience, Report& report, bool i
 			auto batchTargetValues = batch.targetValues;
 			auto batchAdvantages = batch.advantages;
 
-			auto fnRunMinibatch = [&](int start, int stop) {
+			auto fnRunMinibatch = [&](ModelSet& mbModels, LearnStats& stats, int start, int stop) {
+				RG_TRACE_SCOPE("PPO Minibatch", start);
 
 				float batchSizeRatio = (stop - start) / (float)config.batchSize;
 
@@ -188,24 +290,28 @@ void GGL::PPOLearner::Learn(ExperienceBuffer& experience, Report& report, bool i
 				auto oldProbs = batchOldProbs.slice(0, start, stop).to(device, true, true);
 				auto targetValues = batchTargetValues.slice(0, start, stop).to(device, true, true);
 
-				torch::Tensor probs, logProbs, entropy, ratio, clipped, policyLoss, ppoLoss;
+				// Both heads share one forward (and backward) of the shared head
+				torch::Tensor probs, vals;
+				// With mixed precision, only the model layers are autocast, the losses are computed from fp32 outputs
+				ForwardActorCritic(
+					mbModels, obs, actionMasks, config.policyTemperature, config.mixedPrecisionLearn,
+					trainPolicy ? &probs : NULL, trainCritic ? &vals : NULL
+				);
+
+				torch::Tensor logProbs, entropy, ratio, clipped, policyLoss, ppoLoss;
 				if (trainPolicy) {
 
 					// Get policy log probs and entropy
-					float curEntropy;
 					{
-						probs = InferPolicyProbsFromModels(models, obs, actionMasks, config.policyTemperature, false);
 						logProbs = probs.log().gather(-1, acts.unsqueeze(-1));
 						entropy = ComputeEntropy(probs, actionMasks, config.maskEntropy);
-						curEntropy = entropy.detach().cpu().item<float>();
-						avgEntropy += curEntropy;
+						stats.avgEntropy.Add(entropy);
 					}
 
 					logProbs = logProbs.view_as(oldProbs);
 
 					// Compute PPO loss
 					ratio = exp(logProbs - oldProbs);
-					avgRatio += ratio.mean().detach().cpu().item<float>();
 					clipped = clamp(
 						ratio, 1 - config.clipRange, 1 + config.clipRange
 					);
@@ -214,10 +320,9 @@ void GGL::PPOLearner::Learn(ExperienceBuffer& experience, Report& report, bool i
 					policyLoss = -min(
 						ratio * advantages, clipped * advantages
 					).mean();
-					float curPolicyLoss = policyLoss.detach().cpu().item<float>();
-					avgPolicyLoss += curPolicyLoss;
+					stats.avgPolicyLoss.Add(policyLoss);
 
-					avgRelEntropyLoss += (curEntropy * config.entropyScale) / curPolicyLoss;
+					stats.avgRelEntropyLoss.Add((entropy.detach() * config.entropyScale) / policyLoss.detach());
 
 					ppoLoss = (policyLoss - entropy * config.entropyScale) * batchSizeRatio;
 
@@ -225,11 +330,13 @@ void GGL::PPOLearner::Learn(ExperienceBuffer& experience, Report& report, bool i
 						torch::Tensor guidingProbs;
 						{
 							RG_NO_GRAD;
-							guidingProbs = InferPolicyProbsFromModels(guidingPolicyModels, obs, actionMasks, config.policyTemperature, config.useHalfPrecision);
+							// The guiding models are shared by every thread, and building their half-precision copy isn't thread-safe
+							bool guidingHalfPrec = config.useHalfPrecision && numThreads == 1;
+							guidingProbs = InferPolicyProbsFromModels(guidingPolicyModels, obs, actionMasks, config.policyTemperature, guidingHalfPrec);
 						}
 
 						auto guidingLoss = (guidingProbs - probs).abs().mean();
-						avgGuidingLoss.Add(guidingLoss.detach().cpu().item<float>());
+						stats.avgGuidingLoss.Add(guidingLoss);
 						guidingLoss = guidingLoss * config.guidingStrength;
 						ppoLoss = ppoLoss + guidingLoss;
 					}
@@ -237,12 +344,10 @@ void GGL::PPOLearner::Learn(ExperienceBuffer& experience, Report& report, bool i
 
 				torch::Tensor criticLoss;
 				if (trainCritic) {
-					auto vals = InferCritic(obs);
-
 					// Compute value loss
 					vals = vals.view_as(targetValues);
 					criticLoss = mseLoss(vals, targetValues) * batchSizeRatio;
-					avgCriticLoss += criticLoss.detach().cpu().item<float>();
+					stats.avgCriticLoss.Add(criticLoss);
 				}
 
 				if (trainPolicy) {
@@ -252,10 +357,10 @@ void GGL::PPOLearner::Learn(ExperienceBuffer& experience, Report& report, bool i
 
 						auto logRatio = logProbs - oldProbs;
 						auto klTensor = (exp(logRatio) - 1) - logRatio;
-						avgDivergence += klTensor.mean().detach().cpu().item<float>();
+						stats.avgDivergence.Add(klTensor.mean());
 
 						auto clipFraction = mean((abs(ratio - 1) > config.clipRange).to(kFloat));
-						avgClip += clipFraction.cpu().item<float>();
+						stats.avgClip.Add(clipFraction);
 					}
 				}
 
@@ -270,15 +375,37 @@ void GGL::PPOLearner::Learn(ExperienceBuffer& experience, Report& report, bool i
 				}
 			};
 
-			
-			if (device.is_cpu()) {
+			if (numThreads > 1) {
+				// Split the batch into minibatches (at least one per thread), and give each thread every numThreads'th one
+				int64_t miniBatchSize = config.miniBatchSize > 0 ? config.miniBatchSize : config.batchSize;
+				miniBatchSize = RS_MIN(miniBatchSize, (config.batchSize + numThreads - 1) / numThreads);
+
+				auto fnRunThread = [&](int threadIdx) {
+					ModelSet& threadModels = (threadIdx == 0) ? models : cpuReplicas[threadIdx - 1];
+					int64_t firstStart = threadIdx * miniBatchSize;
+					for (int64_t start = firstStart; start < config.batchSize; start += miniBatchSize * numThreads)
+						fnRunMinibatch(threadModels, threadStats[threadIdx], start, RS_MIN(start + miniBatchSize, config.batchSize));
+				};
+
+				// The pool runs threads 1 and up, this thread runs thread 0
+				RLGC::JobCounter threadJobs;
+				learnThreadPool->StartCountedJobs([&](int idx) { fnRunThread(idx + 1); }, numThreads - 1, threadJobs);
+				fnRunThread(0);
+				threadJobs.Wait();
+
+				// Each minibatch loss is already scaled by its share of the batch, so the summed gradients match the whole batch
+				RG_TRACE_SCOPE("PPO Reduce Grads");
+				for (auto& replica : cpuReplicas)
+					replica.MoveGradsTo(models);
+
+			} else if (device.is_cpu()) {
 				// Just run one minibatch
-				fnRunMinibatch(0, config.batchSize);
+				fnRunMinibatch(models, threadStats[0], 0, config.batchSize);
 			} else {
 				for (int mbs = 0; mbs < config.batchSize; mbs += config.miniBatchSize) {
 					int start = mbs;
 					int stop = start + config.miniBatchSize;
-					fnRunMinibatch(start, stop);
+					fnRunMinibatch(models, threadStats[0], start, stop);
 				}
 			}
 
@@ -290,36 +417,99 @@ void GGL::PPOLearner::Learn(ExperienceBuffer& experience, Report& report, bool i
 			if (trainSharedHead)
 				nn::utils::clip_grad_norm_(models["shared_head"]->parameters(), 0.5f);
 
-			models.StepOptims();
+			{
+				RG_TRACE_SCOPE("PPO Optim Step");
+				models.StepOptims();
+			}
+
+			// The next Learn() copies the params to the replicas anyway, so the last step doesn't need to
+			bool isLastStep = (epoch == config.epochs - 1) && (batchIdx == numBatches - 1);
+			if (!isLastStep)
+				for (auto& replica : cpuReplicas)
+					replica.CopyParamsFrom(models);
 		}
 	}
 
+	LearnStats totalStats = {};
+	for (auto& curThreadStats : threadStats)
+		totalStats.Merge(curThreadStats);
+
 	// Compute magnitude of updates made to the policy and value estimator
 	auto policyAfter = models["policy"]->CopyParams();
 	auto criticAfter = models["critic"]->CopyParams();
 
+	// Params are copied to the CPU, so these don't need a device sync
 	float policyUpdateMagnitude = (policyBefore - policyAfter).norm().item<float>();
 	float criticUpdateMagnitude = (criticBefore - criticAfter).norm().item<float>();
 
+	// Read every stat back in one copy
+	torch::Tensor tStats = torch::stack({
+		totalStats.avgEntropy.Get(device),
+		totalStats.avgDivergence.Get(device),
+		totalStats.avgPolicyLoss.Get(device),
+		totalStats.avgRelEntropyLoss.Get(device),
+		totalStats.avgCriticLoss.Get(device),
+		totalStats.avgGuidingLoss.Get(device),
+		totalStats.avgClip.Get(device)
+	}).cpu();
+	const float* stats = tStats.const_data_ptr<float>();
+
 	// Assemble and return report
-	report["Policy Entropy"] = avgEntropy.Get();
-	report["Mean KL Divergence"] = avgDivergence.Get();
+	report["Policy Entropy"] = stats[0];
+	report["Mean KL Divergence"] = stats[1];
 	if (!isFirstIteration) {
 		// These metrics give bad data on the first iteration, which will mess up graph scaling
 		// So we'll just skip them for the first iteration
-		report["Policy Loss"] = avgPolicyLoss.Get();
-		report["Policy Relative Entropy Loss"] = avgRelEntropyLoss.Get();
-		report["Critic Loss"] = avgCriticLoss.Get();
+		report["Policy Loss"] = stats[2];
+		report["Policy Relative Entropy Loss"] = stats[3];
+		report["Critic Loss"] = stats[4];
 
 		if (config.useGuidingPolicy)
-			report["Guiding Loss"] = avgGuidingLoss.Get();
+			report["Guiding Loss"] = stats[5];
 
-		report["SB3 Clip Fraction"] = avgClip.Get();
+		report["SB3 Clip Fraction"] = stats[6];
 		report["Policy Update Magnitude"] = policyUpdateMagnitude;
 		report["Critic Update Magnitude"] = criticUpdateMagnitude;
 	}
 }
 
+GGL::PPOLearner::MixedPrecisionBenchmark GGL::PPOLearner::BenchmarkMixedPrecision(ExperienceBuffer& experience) {
+	RG_TRACE_SCOPE("Mixed Precision Benchmark");
+
+	// Snapshot the models and optimizer states so both runs start from the same place
+	PackedCheckpoint snapshot = {};
+	models.AddToPacked(snapshot, true);
+	auto policyBefore = models["policy"]->CopyParams();
+
+	auto rngBefore = experience.rng;
+	bool mixedPrecisionBefore = config.mixedPrecisionLearn;
+
+	// The first epoch of a run allocates the shuffle buffer, which shouldn't count towards either run
+	experience.BeginEpoch(config.batchSize, config.overbatching);
+
+	MixedPrecisionBenchmark result = {};
+	torch::Tensor policyUpdates[2];
+	for (int i = 0; i < 2; i++) {
+		config.mixedPrecisionLearn = (i == 1);
+		experience.rng = rngBefore;
+
+		// Learn() reads its stats back at the end, so the device is synced by the time it returns
+		Report trialReport = {};
+		Timer timer = {};
+		Learn(experience, trialReport, true);
+		result.learnTime[i] = timer.Elapsed();
+
+		policyUpdates[i] = models["policy"]->CopyParams() - policyBefore;
+		models.LoadFromPacked(snapshot, false, true);
+	}
+
+	config.mixedPrecisionLearn = mixedPrecisionBefore;
+	experience.rng = rngBefore;
+
+	result.updateCosSim = torch::cosine_similarity(policyUpdates[0], policyUpdates[1], 0).item<float>();
+	return result;
+}
+
 void GGL::PPOLearner::TransferLearn(
 	ModelSet& oldModels,
 	torch::Tensor newObs, torch::Tensor oldObs,
@@ -345,7 +535,7 @@ void GGL::PPOLearner::TransferLearn(
 	auto policyBefore = models["policy"]->CopyParams();
 	
 	for (int i = 0; i < tlConfig.epochs; i++) {
-		torch::Tensor newProbs = InferPolicyProbsFromModels(models, newObs, newActionMasks, config.policyTemperature, false);
+		torch::Tensor newProbs = InferPolicyProbsFromModels(models, newObs, newActionMasks, config.policyTemperature, config.mixedPrecisionLearn);
 
 		// Non-summative KL div	loss
 		torch::Tensor transferLearnLoss;
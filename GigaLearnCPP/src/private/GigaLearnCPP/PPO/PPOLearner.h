@@ -6,6 +6,7 @@
 #include <GigaLearnCPP/PPO/TransferLearnConfig.h>
 
 #include "../Util/Models.h"
+#include <RLGymCPP/ThreadPool.h>
 
 #include <torch/optim/adam.h>
 #include <torch/nn/modules/loss.h>
@@ -21,6 +22,11 @@ namespace GGL {
 		ModelSet models = {};
 		ModelSet guidingPolicyModels = {};
 
+		// Copies of the models for the other threads of CPU data-parallel learning (see PPOLearnerConfig::cpuLearnThreads)
+		std::vector<ModelSet> cpuReplicas = {};
+		// Runs the replicas' minibatches, kept for the lifetime of the learner so threads aren't created for every batch
+		std::unique_ptr<RLGC::ThreadPool> learnThreadPool;
+
 		PPOLearnerConfig config;
 		torch::Device device;
 
@@ -39,7 +45,23 @@ namespace GGL {
 		
 		// If models is null, this->models will be used
 		void InferActions(torch::Tensor obs, torch::Tensor actionMasks, torch::Tensor* outActions, torch::Tensor* outLogProbs, ModelSet* models = NULL);
-		torch::Tensor InferCritic(torch::Tensor obs);
+		torch::Tensor InferCritic(torch::Tensor obs, ModelSet* models = NULL);
+
+		// Infers actions and critic values together, so the shared head is only run once
+		// Models must include the critic
+		void InferActionsAndValues(
+			torch::Tensor obs, torch::Tensor actionMasks, 
+			torch::Tensor* outActions, torch::Tensor* outLogProbs, torch::Tensor* outValues, 
+			ModelSet* models = NULL
+		);
+
+		// Infers the log probs of already-chosen actions, and optionally the critic values, with the shared head only run once
+		// If outValues isn't null, models must include the critic
+		void InferLogProbsAndValues(
+			torch::Tensor obs, torch::Tensor actionMasks, torch::Tensor actions,
+			torch::Tensor* outLogProbs, torch::Tensor* outValues,
+			ModelSet* models = NULL
+		);
 
 		// Perhaps they should be somewhere else? Should probably make an inference interface...
 		static torch::Tensor InferPolicyProbsFromModels(
@@ -55,8 +77,28 @@ namespace GGL {
 			torch::Tensor* outActions, torch::Tensor* outLogProbs
 		);
 
+		// Runs the shared head (if any) once, then feeds its output to the policy and/or critic
+		// Outputs that aren't needed can be null, if outValues isn't null then models must include the critic
+		static void ForwardActorCritic(
+			ModelSet& models,
+			torch::Tensor obs, torch::Tensor actionMasks,
+			float temperature, bool halfPrec,
+			torch::Tensor* outProbs, torch::Tensor* outValues
+		);
+
+		static void SampleActionsFromProbs(torch::Tensor probs, bool deterministic, torch::Tensor* outActions, torch::Tensor* outLogProbs);
+
 		void Learn(ExperienceBuffer& experience, Report& report, bool isFirstIteration);
 
+		struct MixedPrecisionBenchmark {
+			double learnTime[2]; // Time Learn() took in fp32, then with mixedPrecisionLearn
+			float updateCosSim; // Cosine similarity of the two policy updates
+		};
+
+		// Runs Learn() on the experience once in each precision, with the same shuffles, restoring the models and optimizers after each
+		// The experience's shuffle state is restored too, so a following Learn() is unaffected
+		MixedPrecisionBenchmark BenchmarkMixedPrecision(ExperienceBuffer& experience);
+
 		void TransferLearn(
 			ModelSet& oldModels, 
 			torch::Tensor newObs, torch::Tensor oldObs, 
@@ -0,0 +1,240 @@
+#include "RolloutStorage.h"
+
+#include <RLGymCPP/TerminalConditions/TerminalCondition.h>
+#include "GAE.h"
+
+template <typename T>
+inline void CopySlabRows(const torch::Tensor& from, int64_t fromIdx, torch::Tensor& to, int64_t toIdx, int64_t count, int64_t rowSize) {
+	memcpy(
+		to.data_ptr<T>() + toIdx * rowSize,
+		from.const_data_ptr<T>() + fromIdx * rowSize,
+		count * rowSize * sizeof(T)
+	);
+}
+
+GGL::RolloutStorage::RolloutStorage(int numPlayers, int obsSize, int numActions, int64_t capacity) :
+	numPlayers(numPlayers), obsSize(obsSize), numActions(numActions), capacity(0) {
+
+	RG_ASSERT(numPlayers > 0 && capacity > 0);
+
+	gaeState = std::make_unique<GAEState>();
+	commitMutex = std::make_unique<std::mutex>();
+
+	playerLengths.resize(numPlayers, 0);
+	episodeStarts.resize(numPlayers, 0);
+	_Grow(capacity);
+}
+
+void GGL::RolloutStorage::Clear() {
+	if (gaeState) {
+		gaeState->jobs.Wait();
+		gaeState->totalRew = gaeState->totalClippedRew = 0;
+	}
+
+	std::fill(playerLengths.begin(), playerLengths.end(), 0);
+	std::fill(episodeStarts.begin(), episodeStarts.end(), 0);
+	episodes.clear();
+	numCommitted = 0;
+	truncNextStates.clear();
+}
+
+void GGL::RolloutStorage::CarryOverFrom(const RolloutStorage& other) {
+	RG_ASSERT(other.numPlayers == numPlayers);
+
+	Clear();
+
+	int64_t maxTailLength = 0;
+	for (int i = 0; i < numPlayers; i++)
+		maxTailLength = RS_MAX(maxTailLength, other.GetEpisodeLength(i));
+
+	if (maxTailLength > capacity)
+		_Grow(maxTailLength);
+
+	for (int i = 0; i < numPlayers; i++) {
+		int64_t tailLength = other.GetEpisodeLength(i);
+		if (tailLength > 0)
+			_CopySteps(other, i, other.episodeStarts[i], i, 0, tailLength);
+		playerLengths[i] = tailLength;
+	}
+}
+
+void GGL::RolloutStorage::BeginStep(int player, const float* state, const uint8_t* actionMask) {
+	int64_t step = playerLengths[player];
+	if (step >= capacity)
+		_Grow(step + 1);
+
+	int64_t idx = player * capacity + step;
+	memcpy(states.data_ptr<float>() + idx * obsSize, state, obsSize * sizeof(float));
+	memcpy(actionMasks.data_ptr<uint8_t>() + idx * numActions, actionMask, numActions * sizeof(uint8_t));
+}
+
+void GGL::RolloutStorage::EndStep(int player, int action, float logProb, float value, float reward, int8_t terminalType, const float* nextState) {
+	int64_t step = playerLengths[player];
+	int64_t idx = player * capacity + step;
+
+	actions.data_ptr<int32_t>()[idx] = action;
+	logProbs.data_ptr<float>()[idx] = logProb;
+	values.data_ptr<float>()[idx] = value;
+	rewards.data_ptr<float>()[idx] = reward;
+	terminals.data_ptr<int8_t>()[idx] = terminalType;
+
+	playerLengths[player] = step + 1;
+
+	if (terminalType) {
+		EpisodeRange episode = { player, episodeStarts[player], playerLengths[player], -1 };
+		episodeStarts[player] = playerLengths[player];
+
+		{
+			std::lock_guard<std::mutex> lock(*commitMutex);
+
+			if (terminalType == RLGC::TerminalType::TRUNCATED) {
+				// Truncation requires an additional next state for the critic
+				RG_ASSERT(nextState);
+				episode.truncNextStateIdx = truncNextStates.size() / obsSize;
+				truncNextStates.insert(truncNextStates.end(), nextState, nextState + obsSize);
+			}
+
+			episodes.push_back(episode);
+			numCommitted += episode.end - episode.start;
+		}
+
+		if (streamGAE && terminalType != RLGC::TerminalType::TRUNCATED)
+			_StartEpisodeGAE(episode, 0);
+	}
+}
+
+void GGL::RolloutStorage::SortCommitted() {
+	std::sort(episodes.begin(), episodes.end(),
+		[](const EpisodeRange& a, const EpisodeRange& b) {
+			return (a.player != b.player) ? (a.player < b.player) : (a.start < b.start);
+		}
+	);
+
+	// Truncated next states must stay in the same order as their episodes
+	FList sortedTruncNextStates = {};
+	sortedTruncNextStates.reserve(truncNextStates.size());
+	for (auto& episode : episodes) {
+		if (episode.truncNextStateIdx == -1)
+			continue;
+
+		auto itr = truncNextStates.begin() + episode.truncNextStateIdx * obsSize;
+		episode.truncNextStateIdx = sortedTruncNextStates.size() / obsSize;
+		sortedTruncNextStates.insert(sortedTruncNextStates.end(), itr, itr + obsSize);
+	}
+	truncNextStates = std::move(sortedTruncNextStates);
+}
+
+void GGL::RolloutStorage::_StartEpisodeGAE(const EpisodeRange& episode, float truncValPred) {
+	int64_t offset = episode.player * capacity + episode.start;
+	int64_t length = episode.end - episode.start;
+
+	// Slabs can't be reallocated while jobs are running, as _Grow() waits for them first
+	const float* rewardsData = rewards.const_data_ptr<float>() + offset;
+	const int8_t* terminalsData = terminals.const_data_ptr<int8_t>() + offset;
+	const float* valuesData = values.const_data_ptr<float>() + offset;
+	float* advantagesData = advantages.data_ptr<float>() + offset;
+	float* returnsData = returns.data_ptr<float>() + offset;
+
+	GAEState* state = gaeState.get();
+	auto settings = gaeSettings;
+
+	state->jobs.Add(1);
+	RLGC::g_ThreadPool.StartJobAsync(
+		[=]() {
+			state->jobs.Run([&] {
+				float totalRew = 0, totalClippedRew = 0;
+				GAE::ComputeEpisode(
+					rewardsData, terminalsData, valuesData, length, truncValPred,
+					advantagesData, returnsData, totalRew, totalClippedRew,
+					settings.gamma, settings.lambda, settings.returnStd, settings.clipRange
+				);
+
+				std::lock_guard<std::mutex> lock(state->mutex);
+				state->totalRew += totalRew;
+				state->totalClippedRew += totalClippedRew;
+			});
+		}
+	);
+}
+
+void GGL::RolloutStorage::FinishGAE(const float* truncValPreds) {
+	RG_ASSERT(streamGAE);
+
+	int truncIdx = 0;
+	for (auto& episode : episodes) {
+		int64_t lastIdx = episode.player * capacity + episode.end - 1;
+		if (terminals.const_data_ptr<int8_t>()[lastIdx] == RLGC::TerminalType::TRUNCATED) {
+			_StartEpisodeGAE(episode, truncValPreds[truncIdx]);
+			truncIdx++;
+		}
+	}
+
+	RG_ASSERT(truncIdx * obsSize == truncNextStates.size());
+
+	gaeState->jobs.Wait();
+}
+
+torch::Tensor GGL::RolloutStorage::GetCommittedIndices() const {
+	torch::Tensor result = torch::empty({ numCommitted }, torch::kInt64);
+	int64_t* out = result.data_ptr<int64_t>();
+	for (auto& episode : episodes) {
+		int64_t base = episode.player * capacity;
+		for (int64_t i = episode.start; i < episode.end; i++)
+			*(out++) = base + i;
+	}
+
+	return result;
+}
+
+uint64_t GGL::RolloutStorage::GetMemoryUsage() const {
+	uint64_t total = 0;
+	for (auto& slab : GetSlabs())
+		total += GetTensorMemoryUsage(slab);
+
+	total += (playerLengths.capacity() + episodeStarts.capacity()) * sizeof(int64_t);
+	total += episodes.capacity() * sizeof(EpisodeRange);
+	total += truncNextStates.capacity() * sizeof(float);
+	return total;
+}
+
+void GGL::RolloutStorage::_Grow(int64_t minCapacity) {
+	if (gaeState)
+		gaeState->jobs.Wait();
+
+	int64_t newCapacity = RS_MAX(minCapacity, capacity + capacity / 2);
+
+	auto fnMakeSlab = [&](torch::Tensor oldSlab, c10::IntArrayRef rowShape, torch::ScalarType dtype) {
+		std::vector<int64_t> shape = { numPlayers, newCapacity };
+		shape.insert(shape.end(), rowShape.begin(), rowShape.end());
+
+		torch::Tensor newSlab = torch::empty(shape, dtype);
+		if (oldSlab.defined())
+			newSlab.slice(1, 0, capacity).copy_(oldSlab);
+		return newSlab;
+	};
+
+	states = fnMakeSlab(states, { obsSize }, torch::kFloat32);
+	actionMasks = fnMakeSlab(actionMasks, { numActions }, torch::kUInt8);
+	actions = fnMakeSlab(actions, {}, torch::kInt32);
+	logProbs = fnMakeSlab(logProbs, {}, torch::kFloat32);
+	values = fnMakeSlab(values, {}, torch::kFloat32);
+	rewards = fnMakeSlab(rewards, {}, torch::kFloat32);
+	terminals = fnMakeSlab(terminals, {}, torch::kInt8);
+	advantages = fnMakeSlab(advantages, {}, torch::kFloat32);
+	returns = fnMakeSlab(returns, {}, torch::kFloat32);
+
+	capacity = newCapacity;
+}
+
+void GGL::RolloutStorage::_CopySteps(const RolloutStorage& from, int fromPlayer, int64_t fromStart, int player, int64_t start, int64_t count) {
+	int64_t fromIdx = fromPlayer * from.capacity + fromStart;
+	int64_t toIdx = player * capacity + start;
+
+	CopySlabRows<float>(from.states, fromIdx, states, toIdx, count, obsSize);
+	CopySlabRows<uint8_t>(from.actionMasks, fromIdx, actionMasks, toIdx, count, numActions);
+	CopySlabRows<int32_t>(from.actions, fromIdx, actions, toIdx, count, 1);
+	CopySlabRows<float>(from.logProbs, fromIdx, logProbs, toIdx, count, 1);
+	CopySlabRows<float>(from.values, fromIdx, values, toIdx, count, 1);
+	CopySlabRows<float>(from.rewards, fromIdx, rewards, toIdx, count, 1);
+	CopySlabRows<int8_t>(from.terminals, fromIdx, terminals, toIdx, count, 1);
+}
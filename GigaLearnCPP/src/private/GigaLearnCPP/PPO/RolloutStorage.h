@@ -0,0 +1,105 @@
+#pragma once
+#include "../FrameworkTorch.h"
+#include <RLGymCPP/ThreadPool.h>
+
+namespace GGL {
+
+	// Preallocated struct-of-arrays storage for collected experience
+	// Every field is a player-major slab of shape [numPlayers, capacity, ...], with each player writing their steps contiguously
+	// Finished episodes are committed by index range, so nothing is copied until the PPO batches are sampled
+	// EndStep() can be called for different players at the same time, everything else must only be called from one thread
+	class RolloutStorage {
+	public:
+		int numPlayers, obsSize, numActions;
+		int64_t capacity; // Max steps per player, grows if exceeded
+
+		torch::Tensor states, actionMasks, actions, logProbs, values, rewards, terminals;
+		torch::Tensor advantages, returns; // Only written if streamGAE
+
+		// Per-player cursors
+		std::vector<int64_t> playerLengths; // Steps written
+		std::vector<int64_t> episodeStarts; // Start of the in-progress episode
+
+		struct EpisodeRange {
+			int player;
+			int64_t start, end;
+			int64_t truncNextStateIdx; // Index into truncNextStates (in states), -1 if not truncated
+		};
+		std::vector<EpisodeRange> episodes; // Committed (complete) episodes, in commit order
+		int64_t numCommitted = 0;
+
+		FList truncNextStates; // Next states of truncated episodes, in commit order
+
+		std::unique_ptr<std::mutex> commitMutex; // Guards the committed episodes
+
+		// If true, GAE is run on the thread pool for each episode as soon as it is committed
+		// Values must be written during collection
+		// Truncated episodes need the critic's value of their next state, so they are left for FinishGAE()
+		bool streamGAE = false;
+		struct {
+			float gamma, lambda, returnStd, clipRange;
+		} gaeSettings = {};
+
+		struct GAEState {
+			RLGC::JobCounter jobs;
+			std::mutex mutex; // Guards the totals
+			double totalRew = 0, totalClippedRew = 0;
+		};
+		std::unique_ptr<GAEState> gaeState;
+
+		RolloutStorage() = default;
+		RolloutStorage(int numPlayers, int obsSize, int numActions, int64_t capacity);
+
+		// Removes everything, including in-progress episodes
+		void Clear();
+
+		// Clears, then copies all in-progress episodes from another storage so they can continue here
+		void CarryOverFrom(const RolloutStorage& other);
+
+		int64_t GetEpisodeLength(int player) const {
+			return playerLengths[player] - episodeStarts[player];
+		}
+
+		// Writes the state and action mask for the player's next step
+		// Not thread-safe, as the slabs may grow
+		void BeginStep(int player, const float* state, const uint8_t* actionMask);
+
+		// Writes the rest of the step started by BeginStep() and advances the player
+		// The value is the critic's prediction for the step's state, if it was inferred during collection (otherwise unused)
+		// If terminal, the player's episode is committed
+		// A next state must be provided for truncations
+		// Thread-safe for different players
+		void EndStep(int player, int action, float logProb, float value, float reward, int8_t terminalType, const float* nextState = NULL);
+
+		// Episodes committed from multiple threads end up in any order, this sorts them by player so the order is deterministic
+		void SortCommitted();
+
+		// Waits for the streamed GAE jobs, then runs GAE on the truncated episodes
+		// truncValPreds are the critic's predictions for truncNextStates, in the same order
+		void FinishGAE(const float* truncValPreds);
+
+		// Portion of the (standardized) reward magnitude that was clipped during GAE
+		float GetRewClipPortion() const {
+			return (float)((gaeState->totalRew - gaeState->totalClippedRew) / RS_MAX(gaeState->totalRew, 1e-7));
+		}
+
+		// Indices of all committed steps into the flattened slabs, in commit order
+		torch::Tensor GetCommittedIndices() const;
+
+		std::vector<torch::Tensor> GetSlabs() const {
+			return { states, actionMasks, actions, logProbs, values, rewards, terminals, advantages, returns };
+		}
+
+		// Bytes used by the slabs and episode bookkeeping
+		uint64_t GetMemoryUsage() const;
+
+		// Slab viewed as [numPlayers * capacity, ...]
+		static torch::Tensor Flatten(torch::Tensor slab) {
+			return slab.flatten(0, 1);
+		}
+
+		void _StartEpisodeGAE(const EpisodeRange& episode, float truncValPred);
+		void _Grow(int64_t minCapacity);
+		void _CopySteps(const RolloutStorage& from, int fromPlayer, int64_t fromStart, int player, int64_t start, int64_t count);
+	};
+}
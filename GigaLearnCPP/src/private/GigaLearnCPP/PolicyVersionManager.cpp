@@ -61,46 +61,53 @@ GGL::PolicyVersion& GGL::PolicyVersionManager::AddVersion(ModelSet modelsToClone
 	return versions.back();
 }
 
-void GGL::PolicyVersionManager::SaveVersions() {
+void GGL::PolicyVersionManager::SaveVersions(CheckpointWriter* writer) {
 	RG_NO_GRAD;
 
-	// Remove old saved versions
-	std::set<int64_t> allSavedTimesteps = Utils::FindNumberedDirs(saveFolder);
-
-	for (int64_t savedTimesteps : allSavedTimesteps) {
-		bool matchesVersion = false;
-		for (auto& version : versions)
-			matchesVersion |= (savedTimesteps == version.timesteps);
-
-		if (matchesVersion) {
-			// We want to keep this
-			allSavedTimesteps.insert(savedTimesteps);
+	auto fnWrite = [writer](CheckpointWriter::Job&& job) {
+		if (writer) {
+			writer->Queue(std::move(job));
 		} else {
-			// Get rid of it
-			std::filesystem::remove_all(saveFolder / std::to_string(savedTimesteps));
+			CheckpointWriter::WriteJob(job);
 		}
-	}
+	};
 
 	for (auto& version : versions) {
-		if (allSavedTimesteps.contains(version.timesteps))
+		if (version.saved)
 			continue;
-		auto versionSaveFolder = saveFolder / std::to_string(version.timesteps);
-		std::filesystem::create_directories(versionSaveFolder);
-
-		version.models.Save(versionSaveFolder, false);
 
-		{ // Save JSON
-			auto jsonPath = versionSaveFolder / "STATS.json";
+		CheckpointWriter::Job job = {};
+		job.folder = saveFolder / std::to_string(version.timesteps);
 
-			std::ofstream fOut(jsonPath);
-			RG_ASSERT(fOut.good());
+		json j = {};
+		j["skill_ratings"] = version.ratings.ToJSON();
 
-			json j = {};
-			j["skill_ratings"] = version.ratings.ToJSON();
-			std::string jStr = j.dump(4);
-			fOut << jStr;
+		if (packedSaves) {
+			PackedCheckpoint packed = {};
+			version.models.AddToPacked(packed, false);
+			packed.meta = j.dump(4);
+			job.files.push_back({ PackedCheckpoint::FILE_NAME, packed.Serialize() });
+		} else {
+			version.models.Serialize(job.files, false);
+			job.files.push_back({ "STATS.json", j.dump(4) });
 		}
+
+		fnWrite(std::move(job));
+		version.saved = true;
 	}
+
+	// Remove old saved versions
+	std::set<int64_t> keepTimesteps = {};
+	for (auto& version : versions)
+		keepTimesteps.insert(version.timesteps);
+
+	CheckpointWriter::Job removeJob = {};
+	removeJob.onWritten = [saveFolder = this->saveFolder, keepTimesteps]() {
+		for (int64_t savedTimesteps : Utils::FindNumberedDirs(saveFolder))
+			if (!keepTimesteps.contains(savedTimesteps))
+				std::filesystem::remove_all(saveFolder / std::to_string(savedTimesteps));
+	};
+	fnWrite(std::move(removeJob));
 }
 
 void GGL::PolicyVersionManager::LoadVersions(ModelSet modelsTemplate, uint64_t curTimesteps) {
@@ -124,18 +131,25 @@ void GGL::PolicyVersionManager::LoadVersions(ModelSet modelsTemplate, uint64_t c
 		}
 		auto path = saveFolder / std::to_string(savedTimesteps);
 		PolicyVersion& version = AddVersion(modelsTemplate, savedTimesteps);
-		version.models.Load(path, false, false);
+		version.saved = true;
+
+		json j;
+		if (PackedCheckpoint::ExistsIn(path)) {
+			PackedCheckpoint packed = PackedCheckpoint::Load(path / PackedCheckpoint::FILE_NAME);
+			version.models.LoadFromPacked(packed, false, false);
+			j = json::parse(packed.meta);
+		} else {
+			version.models.Load(path, false, false);
 
-		{ // Load JSON
 			// TODO: Repetitive
 			auto jsonPath = path / "STATS.json";
 			std::ifstream fIn(jsonPath);
 			RG_ASSERT(fIn.good());
-
-			json j = json::parse(fIn);
-			if (j.contains("skill_ratings"))
-				version.ratings.ReadFromJSON(j["skill_ratings"]);
+			j = json::parse(fIn);
 		}
+
+		if (j.contains("skill_ratings"))
+			version.ratings.ReadFromJSON(j["skill_ratings"]);
 	}
 
 	SortVersions();
@@ -244,7 +258,7 @@ void GGL::PolicyVersionManager::RunSkillMatches(PPOLearner* ppo, Report& report)
 		auto newActions = TENSOR_TO_VEC<int>(tNewActions);
 		auto oldActions = TENSOR_TO_VEC<int>(tOldActions);
 
-		auto combinedActions = std::vector<int>(skill.envSet->state.numPlayers, -1);
+		auto& combinedActions = skill.envSet->state.actions;
 		for (int i = 0; i < newActions.size(); i++)
 			combinedActions[newPlayers[i]] = newActions[i];
 		for (int i = 0; i < oldActions.size(); i++)
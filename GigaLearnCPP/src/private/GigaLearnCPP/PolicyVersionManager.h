@@ -55,6 +55,7 @@ namespace GGL {
 		uint64_t timesteps;
 		ModelSet models;
 		SkillRating ratings;
+		bool saved = false; // If this version has been saved (or queued to be saved)
 	};
 
 	struct PolicyVersionManager {
@@ -62,6 +63,7 @@ namespace GGL {
 		std::filesystem::path saveFolder;
 		int maxVersions;
 		uint64_t tsPerVersion;
+		bool packedSaves = false; // Save versions as packed checkpoints
 
 		//////////////////
 
@@ -91,11 +93,20 @@ namespace GGL {
 		// NOTE: Passed models should not be already cloned
 		PolicyVersion& AddVersion(ModelSet modelsToClone, uint64_t timesteps);
 
-		void SaveVersions();
+		// If a writer is passed, versions are copied into memory and written on its thread
+		void SaveVersions(CheckpointWriter* writer = NULL);
 		void LoadVersions(ModelSet modelsTemplate, uint64_t curTimesteps);
 
 		void SortVersions();
 
+		// Bytes used by the stored versions' models
+		uint64_t GetMemoryUsage() {
+			uint64_t total = 0;
+			for (auto& version : versions)
+				total += version.models.GetMemoryUsage(false);
+			return total;
+		}
+
 		void RunSkillMatches(struct PPOLearner* ppo, Report& report);
 
 		void OnIteration(struct PPOLearner* ppo, Report& report, int64_t totalTimesteps, int64_t prevTotalTimesteps);
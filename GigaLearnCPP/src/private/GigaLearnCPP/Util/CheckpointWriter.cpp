@@ -0,0 +1,93 @@
+#include "CheckpointWriter.h"
+#include <RLGymCPP/Tracer.h>
+
+GGL::CheckpointWriter::CheckpointWriter() {
+	thread = std::thread([this]() { _ThreadLoop(); });
+}
+
+void GGL::CheckpointWriter::Queue(Job job) {
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		jobs.push_back(std::move(job));
+	}
+	cv.notify_all();
+}
+
+void GGL::CheckpointWriter::WaitUntilIdle() {
+	std::unique_lock<std::mutex> lock(mutex);
+	cv.wait(lock, [this]() { return jobs.empty() && !busy; });
+}
+
+void GGL::CheckpointWriter::WriteJob(const Job& job) {
+	if (job.folder.empty()) {
+		if (job.onWritten)
+			job.onWritten();
+		return;
+	}
+
+	RG_TRACE_SCOPE("Write Checkpoint");
+	std::filesystem::path tempFolder = job.folder;
+	tempFolder += "_tmp";
+
+	try {
+		if (std::filesystem::exists(tempFolder))
+			std::filesystem::remove_all(tempFolder);
+
+		for (auto& file : job.files) {
+			std::filesystem::path path = tempFolder / file.relPath;
+			std::filesystem::create_directories(path.parent_path());
+
+			std::ofstream fOut(path, std::ios::binary);
+			if (!fOut.good())
+				RG_ERR_CLOSE("CheckpointWriter: Failed to open " << path << " for writing");
+			fOut.write(file.data.data(), file.data.size());
+			if (!fOut.good())
+				RG_ERR_CLOSE("CheckpointWriter: Failed to write to " << path);
+		}
+
+		if (std::filesystem::exists(job.folder))
+			std::filesystem::remove_all(job.folder);
+		std::filesystem::rename(tempFolder, job.folder);
+	} catch (std::exception& e) {
+		RG_ERR_CLOSE("CheckpointWriter: Failed to write checkpoint to " << job.folder << ", exception: " << e.what());
+	}
+
+	if (job.onWritten)
+		job.onWritten();
+}
+
+void GGL::CheckpointWriter::_ThreadLoop() {
+	RLGC::g_Tracer.SetThreadName("Checkpoint Writer");
+	while (true) {
+		Job job;
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			cv.wait(lock, [this]() { return stop || !jobs.empty(); });
+			if (jobs.empty())
+				return; // Stopped and nothing left to write
+
+			job = std::move(jobs.front());
+			jobs.pop_front();
+			busy = true;
+		}
+
+		WriteJob(job);
+
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			busy = false;
+		}
+		cv.notify_all();
+	}
+}
+
+GGL::CheckpointWriter::~CheckpointWriter() {
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stop = true;
+	}
+	cv.notify_all();
+
+	if (thread.joinable())
+		thread.join();
+}
@@ -0,0 +1,46 @@
+#pragma once
+#include <GigaLearnCPP/Framework.h>
+#include <condition_variable>
+
+namespace GGL {
+
+	// A file to write, already serialized into memory
+	struct CheckpointFile {
+		std::filesystem::path relPath; // Relative to the checkpoint folder
+		std::string data;
+	};
+
+	// Writes checkpoint folders on a background thread, so saving doesn't stall training
+	// Each folder is written to a temporary folder first, then renamed, so a folder that exists is always complete
+	class CheckpointWriter {
+	public:
+		struct Job {
+			std::filesystem::path folder; // If empty, nothing is written and only onWritten is called
+			std::vector<CheckpointFile> files;
+			std::function<void()> onWritten = NULL; // Called from the writer thread once the folder is in place
+		};
+
+		std::thread thread;
+		std::mutex mutex;
+		std::condition_variable cv;
+		std::deque<Job> jobs;
+		bool busy = false;
+		bool stop = false;
+
+		CheckpointWriter();
+		RG_NO_COPY(CheckpointWriter);
+
+		// Jobs are written in the order they are queued
+		void Queue(Job job);
+
+		// Blocks until every queued job is written
+		void WaitUntilIdle();
+
+		// Finishes writing all queued jobs
+		~CheckpointWriter();
+
+		static void WriteJob(const Job& job);
+
+		void _ThreadLoop();
+	};
+}
@@ -35,8 +35,15 @@ GGL::Model::Model(
 
 torch::Tensor GGL::Model::Forward(torch::Tensor input, bool halfPrec) {
 
-	if (torch::GradMode::is_enabled())
-		halfPrec = false;
+	if (halfPrec && torch::GradMode::is_enabled()) {
+		// Mixed-precision training: the fp32 parameters are cast on the fly, so gradients and optimizer steps stay in fp32
+		torch::Tensor output;
+		{
+			RG_AUTOCAST(input.device().type());
+			output = seq->forward(input);
+		}
+		return output.to(torch::kFloat);
+	}
 
 	if (halfPrec) {
 
@@ -87,14 +94,25 @@ void GGL::Model::StepOptim() {
 }
 
 void GGL::Model::Save(std::filesystem::path folder, bool saveOptim) {
-	std::filesystem::path path = GetSavePath(folder);
-	auto streamOut = std::ofstream(path, std::ios::binary);
-	torch::save(seq, streamOut);
+	std::vector<CheckpointFile> files = {};
+	Serialize(files, saveOptim);
+	for (auto& file : files) {
+		auto streamOut = std::ofstream(folder / file.relPath, std::ios::binary);
+		streamOut.write(file.data.data(), file.data.size());
+	}
+}
+
+void GGL::Model::Serialize(std::vector<CheckpointFile>& outFiles, bool serializeOptim) {
+	std::ostringstream modelStream;
+	torch::save(seq, modelStream);
+	outFiles.push_back({ GetSavePath({}), modelStream.str() });
 
-	if (saveOptim) {
+	if (serializeOptim) {
+		std::ostringstream optimStream;
 		torch::serialize::OutputArchive optimArchive;
 		optim->save(optimArchive);
-		optimArchive.save_to(GetOptimSavePath(folder).string());
+		optimArchive.save_to(optimStream);
+		outFiles.push_back({ GetOptimSavePath({}), optimStream.str() });
 	}
 }
 
@@ -170,3 +188,214 @@ void GGL::Model::Load(std::filesystem::path folder, bool allowNotExist, bool loa
 torch::Tensor GGL::Model::CopyParams() const {
 	return torch::nn::utils::parameters_to_vector(parameters()).cpu();
 }
+
+void GGL::Model::SetParams(torch::Tensor flatParams) {
+	RG_NO_GRAD;
+
+	auto params = parameters();
+	int64_t offset = 0;
+	for (auto& param : params) {
+		int64_t numel = param.numel();
+		if (offset + numel > flatParams.size(0))
+			RG_ERR_CLOSE("Model::SetParams(): Not enough params for model \"" << modelName << "\"");
+
+		param.copy_(flatParams.slice(0, offset, offset + numel).view_as(param));
+		offset += numel;
+	}
+
+	if (offset != flatParams.size(0))
+		RG_ERR_CLOSE("Model::SetParams(): Too many params for model \"" << modelName << "\" (" << flatParams.size(0) << " vs " << offset << ")");
+
+	_seqHalfOutdated = true;
+}
+
+namespace {
+	// Adam and AdamW have identically laid out param states, but they don't share a type
+	template <typename StateT>
+	void AddAdamStatesToPacked(GGL::PackedCheckpoint& packed, const std::string& prefix, torch::optim::Optimizer* optim, const std::vector<torch::Tensor>& params) {
+		for (int i = 0; i < params.size(); i++) {
+			auto itr = optim->state().find(params[i].unsafeGetTensorImpl());
+			if (itr == optim->state().end())
+				continue; // Not stepped yet
+
+			auto& state = static_cast<StateT&>(*itr->second);
+			std::string statePrefix = prefix + std::to_string(i) + "/";
+			packed.Add(statePrefix + "step", torch::tensor(state.step(), torch::kInt64));
+			packed.Add(statePrefix + "exp_avg", state.exp_avg());
+			packed.Add(statePrefix + "exp_avg_sq", state.exp_avg_sq());
+			if (state.max_exp_avg_sq().defined())
+				packed.Add(statePrefix + "max_exp_avg_sq", state.max_exp_avg_sq());
+		}
+	}
+
+	// Returns the number of param states loaded
+	template <typename StateT>
+	int LoadAdamStatesFromPacked(const GGL::PackedCheckpoint& packed, const std::string& prefix, torch::optim::Optimizer* optim, const std::vector<torch::Tensor>& params) {
+		int numLoaded = 0;
+		for (int i = 0; i < params.size(); i++) {
+			std::string statePrefix = prefix + std::to_string(i) + "/";
+			torch::Tensor step = packed.Get(statePrefix + "step");
+			if (!step.defined())
+				continue;
+
+			// Copy out of the mapped file
+			auto fnCopy = [&](const char* name) -> torch::Tensor {
+				torch::Tensor saved = packed.Get(statePrefix + name);
+				if (!saved.defined())
+					return {};
+				if (saved.sizes() != params[i].sizes())
+					RG_ERR_CLOSE("Saved optimizer state \"" << statePrefix << name << "\" has a different size than its parameter");
+				return saved.to(params[i].device(), false, true);
+			};
+
+			auto state = std::make_unique<StateT>();
+			state->step(step.item<int64_t>());
+			state->exp_avg(fnCopy("exp_avg"));
+			state->exp_avg_sq(fnCopy("exp_avg_sq"));
+			state->max_exp_avg_sq(fnCopy("max_exp_avg_sq"));
+			optim->state()[params[i].unsafeGetTensorImpl()] = std::move(state);
+			numLoaded++;
+		}
+		return numLoaded;
+	}
+
+	template <typename StateT>
+	uint64_t GetAdamStateMemoryUsage(torch::optim::Optimizer* optim) {
+		uint64_t total = 0;
+		for (auto& pair : optim->state()) {
+			auto& state = static_cast<StateT&>(*pair.second);
+			total += GGL::GetTensorMemoryUsage(state.exp_avg());
+			total += GGL::GetTensorMemoryUsage(state.exp_avg_sq());
+			total += GGL::GetTensorMemoryUsage(state.max_exp_avg_sq());
+		}
+		return total;
+	}
+}
+
+uint64_t GGL::Model::GetMemoryUsage(bool includeOptim) {
+	uint64_t total = 0;
+	for (auto& param : parameters()) {
+		total += GetTensorMemoryUsage(param);
+		total += GetTensorMemoryUsage(param.grad());
+	}
+	for (auto& buffer : buffers())
+		total += GetTensorMemoryUsage(buffer);
+	for (auto& param : seqHalf->parameters())
+		total += GetTensorMemoryUsage(param);
+
+	if (includeOptim) {
+		switch (config.optimType) {
+		case ModelOptimType::ADAM:
+			total += GetAdamStateMemoryUsage<torch::optim::AdamParamState>(optim);
+			break;
+		case ModelOptimType::ADAMW:
+			total += GetAdamStateMemoryUsage<torch::optim::AdamWParamState>(optim);
+			break;
+		default:
+			// The other optimizers keep about one state tensor per stepped param
+			for (auto& param : parameters()) {
+				if (optim->state().find(param.unsafeGetTensorImpl()) != optim->state().end())
+					total += GetTensorMemoryUsage(param);
+			}
+		}
+	}
+
+	return total;
+}
+
+void GGL::Model::AddToPacked(PackedCheckpoint& packed, bool addOptim) {
+	std::string prefix = std::string(modelName) + "/";
+
+	for (auto& pair : named_parameters())
+		packed.Add(prefix + pair.key(), pair.value());
+	for (auto& pair : named_buffers())
+		packed.Add(prefix + pair.key(), pair.value());
+
+	if (addOptim) {
+		std::string optimPrefix = prefix + "optim/";
+		switch (config.optimType) {
+		case ModelOptimType::ADAM:
+			AddAdamStatesToPacked<torch::optim::AdamParamState>(packed, optimPrefix, optim, parameters());
+			break;
+		case ModelOptimType::ADAMW:
+			AddAdamStatesToPacked<torch::optim::AdamWParamState>(packed, optimPrefix, optim, parameters());
+			break;
+		default:
+			{
+				// No raw layout for this optimizer's state, so just store its archive
+				std::ostringstream optimStream;
+				torch::serialize::OutputArchive optimArchive;
+				optim->save(optimArchive);
+				optimArchive.save_to(optimStream);
+				std::string optimBytes = optimStream.str();
+				packed.Add(optimPrefix + "archive", torch::from_blob(optimBytes.data(), { (int64_t)optimBytes.size() }, torch::kUInt8).clone());
+			}
+		}
+	}
+}
+
+void GGL::Model::LoadFromPacked(const PackedCheckpoint& packed, bool allowNotExist, bool loadOptim) {
+	RG_NO_GRAD;
+
+	std::string prefix = std::string(modelName) + "/";
+
+	auto namedParams = named_parameters();
+	if (!packed.Get(prefix + namedParams.begin()->key()).defined()) {
+		if (allowNotExist) {
+			RG_LOG("Warning: Model \"" << modelName << "\" does not exist in packed checkpoint and will be reset");
+			return;
+		} else {
+			RG_ERR_CLOSE("Model \"" << modelName << "\" does not exist in packed checkpoint");
+		}
+	}
+
+	auto fnLoadTensor = [&](const std::string& name, torch::Tensor& to) {
+		torch::Tensor saved = packed.Get(prefix + name);
+		if (!saved.defined())
+			RG_ERR_CLOSE("Packed checkpoint is missing \"" << prefix << name << "\", it may be of a different model arch");
+
+		if (saved.sizes() != to.sizes()) {
+			RG_ERR_CLOSE(
+				"Saved \"" << prefix << name << "\" has a different size than the current model, cannot load model:\n" <<
+				" > Current model: " << to.sizes() << "\n" <<
+				" > Saved model:   " << saved.sizes()
+			);
+		}
+
+		to.copy_(saved);
+	};
+
+	for (auto& pair : namedParams)
+		fnLoadTensor(pair.key(), pair.value());
+	for (auto& pair : named_buffers())
+		fnLoadTensor(pair.key(), pair.value());
+	_seqHalfOutdated = true;
+
+	if (loadOptim) {
+		std::string optimPrefix = prefix + "optim/";
+		bool loadedOptim = false;
+		switch (config.optimType) {
+		case ModelOptimType::ADAM:
+			optim->state().clear();
+			loadedOptim = LoadAdamStatesFromPacked<torch::optim::AdamParamState>(packed, optimPrefix, optim, parameters()) > 0;
+			break;
+		case ModelOptimType::ADAMW:
+			optim->state().clear();
+			loadedOptim = LoadAdamStatesFromPacked<torch::optim::AdamWParamState>(packed, optimPrefix, optim, parameters()) > 0;
+			break;
+		default:
+			{
+				torch::Tensor archiveBytes = packed.Get(optimPrefix + "archive");
+				if (archiveBytes.defined()) {
+					torch::serialize::InputArchive optimArchive;
+					optimArchive.load_from((const char*)archiveBytes.data_ptr(), archiveBytes.nbytes(), device);
+					optim->load(optimArchive);
+					loadedOptim = true;
+				}
+			}
+		}
+
+		if (!loadedOptim)
+			RG_LOG("WARNING: No optimizer state for \"" << modelName << "\" in packed checkpoint, optimizer will be reset");
+	}
+}
@@ -12,6 +12,8 @@
 #include <torch/optim/sgd.h>
 
 #include "MagSGD.h"
+#include "CheckpointWriter.h"
+#include "PackedCheckpoint.h"
 
 #include <GigaLearnCPP/PPO/PPOLearnerConfig.h>
 #include <GigaLearnCPP/Util/ModelConfig.h>
@@ -124,24 +126,67 @@ namespace GGL {
 		virtual void Save(std::filesystem::path folder, bool saveOptim = true);
 		virtual void Load(std::filesystem::path folder, bool allowNotExist, bool loadOptim = true);
 
+		// Serializes the model (and optimizer) into memory, with paths relative to the save folder
+		// Tensors are copied to the host, so the model can keep training while the files are written
+		virtual void Serialize(std::vector<CheckpointFile>& outFiles, bool serializeOptim = true);
+
+		// Adds params (and optimizer state) as "<modelName>/..." tensors
+		virtual void AddToPacked(PackedCheckpoint& packed, bool addOptim = true);
+		virtual void LoadFromPacked(const PackedCheckpoint& packed, bool allowNotExist, bool loadOptim = true);
+
 		virtual torch::Tensor CopyParams() const;
 
+		// Sets all parameters from a flat tensor, in the same layout as CopyParams()
+		virtual void SetParams(torch::Tensor flatParams);
+
 		// NOTE: Resets parameters
 		Model* MakeEmptyClone() {
 			return new Model(modelName, config, device);
 		}
 
-		Model* MakeClone() {
+		// Copies parameter values from another model with the same config
+		void CopyParamsFrom(Model* other) {
 			RG_NO_GRAD;
 
-			Model* clone = MakeEmptyClone();
-			auto fromParams = this->parameters();
-			auto toParams = clone->parameters();
+			auto fromParams = other->parameters();
+			auto toParams = this->parameters();
+			RG_ASSERT(fromParams.size() == toParams.size());
 			for (int i = 0; i < fromParams.size(); i++)
 				toParams[i].copy_(fromParams[i], true);
+			_seqHalfOutdated = true;
+		}
+
+		// Adds this model's gradients to those of another model with the same layout, then zeros them
+		void MoveGradsTo(Model* other) {
+			RG_NO_GRAD;
+
+			auto fromParams = this->parameters();
+			auto toParams = other->parameters();
+			RG_ASSERT(fromParams.size() == toParams.size());
+			for (int i = 0; i < fromParams.size(); i++) {
+				auto& fromGrad = fromParams[i].mutable_grad();
+				if (!fromGrad.defined())
+					continue;
+
+				auto& toGrad = toParams[i].mutable_grad();
+				if (toGrad.defined()) {
+					toGrad.add_(fromGrad);
+				} else {
+					toGrad = fromGrad.clone();
+				}
+				fromGrad.zero_();
+			}
+		}
+
+		Model* MakeClone() {
+			Model* clone = MakeEmptyClone();
+			clone->CopyParamsFrom(this);
 			return clone;
 		}
 
+		// Bytes used by the params, grads, buffers and half-precision copy, and optionally the optimizer state
+		uint64_t GetMemoryUsage(bool includeOptim = true);
+
 		uint64_t GetParamCount() {
 			uint64_t total = 0;
 			for (auto& param : this->parameters()) {
@@ -185,7 +230,28 @@ namespace GGL {
 				model->Save(folder, saveOptims);
 		}
 
+		void Serialize(std::vector<CheckpointFile>& outFiles, bool serializeOptims = true) {
+			for (auto& pair : map)
+				pair.second->Serialize(outFiles, serializeOptims);
+		}
+
+		void AddToPacked(PackedCheckpoint& packed, bool addOptims = true) {
+			for (auto& pair : map)
+				pair.second->AddToPacked(packed, addOptims);
+		}
+
+		void LoadFromPacked(const PackedCheckpoint& packed, bool allowNotExist, bool loadOptims) {
+			for (auto& pair : map)
+				pair.second->LoadFromPacked(packed, allowNotExist, loadOptims);
+		}
+
+		// Loads from a packed checkpoint if the folder has one, otherwise from the per-model files
 		void Load(std::filesystem::path folder, bool allowNotExist, bool loadOptims) {
+			if (PackedCheckpoint::ExistsIn(folder)) {
+				LoadFromPacked(PackedCheckpoint::Load(folder / PackedCheckpoint::FILE_NAME), allowNotExist, loadOptims);
+				return;
+			}
+
 			for (Model* model : *this)
 				model->Load(folder, allowNotExist, loadOptims);
 		}
@@ -220,6 +286,33 @@ namespace GGL {
 			return clone;
 		}
 
+		// Copies parameter values from the models with matching names in another set
+		void CopyParamsFrom(ModelSet& other) {
+			for (auto& pair : map) {
+				Model* otherModel = other[pair.first];
+				if (!otherModel)
+					RG_ERR_CLOSE("ModelSet::CopyParamsFrom(): Missing model \"" << pair.first << "\"");
+				pair.second->CopyParamsFrom(otherModel);
+			}
+		}
+
+		// Adds the gradients of each model to the model with the matching name in another set, then zeros them
+		void MoveGradsTo(ModelSet& other) {
+			for (auto& pair : map) {
+				Model* otherModel = other[pair.first];
+				if (!otherModel)
+					RG_ERR_CLOSE("ModelSet::MoveGradsTo(): Missing model \"" << pair.first << "\"");
+				pair.second->MoveGradsTo(otherModel);
+			}
+		}
+
+		uint64_t GetMemoryUsage(bool includeOptims = true) {
+			uint64_t total = 0;
+			for (auto& pair : map)
+				total += pair.second->GetMemoryUsage(includeOptims);
+			return total;
+		}
+
 		void Free() {
 			for (Model* model : *this)
 				delete model;
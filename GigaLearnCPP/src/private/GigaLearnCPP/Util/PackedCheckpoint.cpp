@@ -0,0 +1,205 @@
+#include "PackedCheckpoint.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace GGL {
+	// Read-only view of a whole file, mapped copy-on-write
+	class MappedFile {
+	public:
+		uint8_t* data = NULL;
+		size_t size = 0;
+
+#ifdef _WIN32
+		HANDLE fileHandle = INVALID_HANDLE_VALUE, mapHandle = NULL;
+#endif
+
+		MappedFile(std::filesystem::path path) {
+#ifdef _WIN32
+			fileHandle = CreateFileW(path.wstring().c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+			if (fileHandle == INVALID_HANDLE_VALUE)
+				RG_ERR_CLOSE("MappedFile: Failed to open " << path);
+
+			LARGE_INTEGER fileSize;
+			GetFileSizeEx(fileHandle, &fileSize);
+			size = fileSize.QuadPart;
+			if (size == 0)
+				return;
+
+			mapHandle = CreateFileMappingW(fileHandle, NULL, PAGE_WRITECOPY, 0, 0, NULL);
+			if (mapHandle)
+				data = (uint8_t*)MapViewOfFile(mapHandle, FILE_MAP_COPY, 0, 0, 0);
+#else
+			int fd = open(path.c_str(), O_RDONLY);
+			if (fd == -1)
+				RG_ERR_CLOSE("MappedFile: Failed to open " << path);
+
+			struct stat fileStat;
+			fstat(fd, &fileStat);
+			size = fileStat.st_size;
+			if (size == 0) {
+				close(fd);
+				return;
+			}
+
+			void* mapped = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+			close(fd); // The mapping keeps its own reference
+			if (mapped != MAP_FAILED)
+				data = (uint8_t*)mapped;
+#endif
+
+			if (!data)
+				RG_ERR_CLOSE("MappedFile: Failed to map " << path);
+		}
+
+		RG_NO_COPY(MappedFile);
+
+		~MappedFile() {
+#ifdef _WIN32
+			if (data)
+				UnmapViewOfFile(data);
+			if (mapHandle)
+				CloseHandle(mapHandle);
+			if (fileHandle != INVALID_HANDLE_VALUE)
+				CloseHandle(fileHandle);
+#else
+			if (data)
+				munmap(data, size);
+#endif
+		}
+	};
+}
+
+struct PackedHeader {
+	uint64_t magic;
+	uint32_t formatVersion;
+	uint32_t numTensors;
+	uint64_t metaSize;
+};
+
+void GGL::PackedCheckpoint::Add(const std::string& name, torch::Tensor tensor) {
+	if (tensors.contains(name))
+		RG_ERR_CLOSE("PackedCheckpoint::Add(): Duplicate tensor name \"" << name << "\"");
+
+	tensors[name] = tensor.detach().cpu().contiguous();
+}
+
+std::string GGL::PackedCheckpoint::Serialize() const {
+	std::string result = {};
+
+	auto fnWrite = [&](const void* data, size_t size) {
+		result.append((const char*)data, size);
+	};
+
+	auto fnPad = [&]() {
+		result.resize((result.size() + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT, '\0');
+	};
+
+	// Size of everything before the tensor data, so we know the data offsets up front
+	uint64_t dataStart = sizeof(PackedHeader);
+	for (auto& pair : tensors)
+		dataStart += sizeof(uint32_t) + pair.first.size() + sizeof(int32_t) + sizeof(uint32_t) + pair.second.dim() * sizeof(int64_t) + sizeof(uint64_t) * 2;
+	dataStart += meta.size();
+
+	PackedHeader header = { MAGIC, FORMAT_VERSION, (uint32_t)tensors.size(), meta.size() };
+	fnWrite(&header, sizeof(header));
+
+	uint64_t dataOffset = (dataStart + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+	for (auto& pair : tensors) {
+		auto& tensor = pair.second;
+
+		uint32_t nameSize = pair.first.size();
+		fnWrite(&nameSize, sizeof(nameSize));
+		fnWrite(pair.first.data(), nameSize);
+
+		int32_t dtype = (int32_t)tensor.scalar_type();
+		uint32_t numDims = tensor.dim();
+		fnWrite(&dtype, sizeof(dtype));
+		fnWrite(&numDims, sizeof(numDims));
+		for (int64_t size : tensor.sizes())
+			fnWrite(&size, sizeof(size));
+
+		uint64_t numBytes = tensor.nbytes();
+		fnWrite(&dataOffset, sizeof(dataOffset));
+		fnWrite(&numBytes, sizeof(numBytes));
+
+		dataOffset = (dataOffset + numBytes + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+	}
+
+	fnWrite(meta.data(), meta.size());
+	RG_ASSERT(result.size() == dataStart);
+
+	result.reserve(dataOffset);
+	for (auto& pair : tensors) {
+		fnPad();
+		fnWrite(pair.second.data_ptr(), pair.second.nbytes());
+	}
+	fnPad();
+
+	return result;
+}
+
+GGL::PackedCheckpoint GGL::PackedCheckpoint::Load(std::filesystem::path path) {
+	constexpr const char* ERROR_PREFIX = "PackedCheckpoint::Load(): ";
+
+	auto mappedFile = std::make_shared<MappedFile>(path);
+	uint8_t* data = mappedFile->data;
+	size_t pos = 0;
+
+	auto fnRead = [&](void* out, size_t size) {
+		if (pos + size > mappedFile->size)
+			RG_ERR_CLOSE(ERROR_PREFIX << "File " << path << " is truncated or corrupt");
+		memcpy(out, data + pos, size);
+		pos += size;
+	};
+
+	PackedHeader header;
+	fnRead(&header, sizeof(header));
+	if (header.magic != MAGIC)
+		RG_ERR_CLOSE(ERROR_PREFIX << "File " << path << " is not a packed checkpoint");
+	if (header.formatVersion != FORMAT_VERSION)
+		RG_ERR_CLOSE(ERROR_PREFIX << "File " << path << " has unsupported format version " << header.formatVersion << " (expected " << FORMAT_VERSION << ")");
+
+	PackedCheckpoint result = {};
+	result._mappedFile = mappedFile;
+
+	for (uint32_t i = 0; i < header.numTensors; i++) {
+		uint32_t nameSize;
+		fnRead(&nameSize, sizeof(nameSize));
+		std::string name(nameSize, '\0');
+		fnRead(name.data(), nameSize);
+
+		int32_t dtype;
+		uint32_t numDims;
+		fnRead(&dtype, sizeof(dtype));
+		fnRead(&numDims, sizeof(numDims));
+		std::vector<int64_t> sizes(numDims);
+		fnRead(sizes.data(), numDims * sizeof(int64_t));
+
+		uint64_t dataOffset, numBytes;
+		fnRead(&dataOffset, sizeof(dataOffset));
+		fnRead(&numBytes, sizeof(numBytes));
+		if (dataOffset + numBytes > mappedFile->size)
+			RG_ERR_CLOSE(ERROR_PREFIX << "File " << path << " is truncated or corrupt (tensor \"" << name << "\" is out of bounds)");
+
+		auto options = torch::TensorOptions().dtype((torch::ScalarType)dtype);
+		torch::Tensor tensor = torch::from_blob(data + dataOffset, sizes, [mappedFile](void*) {}, options);
+		if (tensor.nbytes() != numBytes)
+			RG_ERR_CLOSE(ERROR_PREFIX << "File " << path << " is corrupt (tensor \"" << name << "\" has the wrong size)");
+
+		result.tensors[name] = tensor;
+	}
+
+	result.meta.resize(header.metaSize);
+	fnRead(result.meta.data(), header.metaSize);
+
+	return result;
+}
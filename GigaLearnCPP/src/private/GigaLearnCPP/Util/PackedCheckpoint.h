@@ -0,0 +1,47 @@
+#pragma once
+#include "../FrameworkTorch.h"
+
+namespace GGL {
+
+	// A whole checkpoint (every model, optimizer state, and a JSON metadata string) in one file
+	// Loading memory-maps the file and points tensors straight at their data, so nothing is parsed or copied until the params are set
+	//
+	// File layout:
+	//	Header { magic, formatVersion, numTensors, metaSize }
+	//	Tensor table, one entry per tensor { nameSize, name, dtype, numDims, sizes[numDims], dataOffset, numBytes }
+	//	Metadata string
+	//	Tensor data, each starting at a multiple of PackedCheckpoint::ALIGNMENT from the start of the file
+	//
+	// NOTE: Written in native byte order, like the rollout messages
+	class PackedCheckpoint {
+	public:
+		constexpr static const char* FILE_NAME = "CHECKPOINT.ggl";
+		constexpr static uint64_t MAGIC = 0x31304B5043474747; // "GGGCPK01"
+		constexpr static uint32_t FORMAT_VERSION = 1;
+		constexpr static uint64_t ALIGNMENT = 64;
+
+		std::map<std::string, torch::Tensor> tensors;
+		std::string meta; // Usually JSON
+
+		// Keeps the file mapped for as long as any loaded tensor still points into it
+		std::shared_ptr<class MappedFile> _mappedFile;
+
+		// Tensors are copied to the host
+		void Add(const std::string& name, torch::Tensor tensor);
+
+		// Returns an undefined tensor if there is none with that name
+		torch::Tensor Get(const std::string& name) const {
+			auto itr = tensors.find(name);
+			return (itr != tensors.end()) ? itr->second : torch::Tensor();
+		}
+
+		std::string Serialize() const;
+
+		static bool ExistsIn(std::filesystem::path folder) {
+			return std::filesystem::exists(folder / FILE_NAME);
+		}
+
+		// Loaded tensors are on the CPU and read from the mapped file (copy-on-write, so the file is never modified)
+		static PackedCheckpoint Load(std::filesystem::path path);
+	};
+}
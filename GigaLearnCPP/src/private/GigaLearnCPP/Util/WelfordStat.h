@@ -79,6 +79,23 @@ namespace GGL {
 			count++;
 		}
 
+		// Merges in stats from another set of samples, using Chan et al.'s parallel variance formula
+		// otherM2s is the sum of squared differences from the mean (what runningVariances holds)
+		void Merge(const std::vector<double>& otherMeans, const std::vector<double>& otherM2s, int64_t otherCount) {
+			if (otherCount == 0)
+				return;
+
+			RG_ASSERT(otherMeans.size() == width && otherM2s.size() == width);
+
+			double newCount = (double)(count + otherCount);
+			for (int i = 0; i < width; i++) {
+				double delta = otherMeans[i] - runningMeans[i];
+				runningMeans[i] += delta * (otherCount / newCount);
+				runningVariances[i] += otherM2s[i] + delta * delta * (count * (double)otherCount / newCount);
+			}
+			count += otherCount;
+		}
+
 		void Reset() {
 			*this = BatchedWelfordStat(width);
 		}
@@ -112,8 +129,8 @@ namespace GGL {
 		}
 
 		void ReadFromJSON(const nlohmann::json& json) {
-			runningMeans = Utils::MakeVecFromJSON<double>(json["mean"]);
-			runningVariances = Utils::MakeVecFromJSON<double>(json["var"]);
+			runningMeans = Utils::MakeVecFromJSON<double>(json["means"]);
+			runningVariances = Utils::MakeVecFromJSON<double>(json["vars"]);
 			count = json["count"];
 		}
 	};
@@ -0,0 +1,29 @@
+#pragma once
+
+#include "Framework.h"
+
+namespace GGL {
+	// Calibrates numGames, the env thread count, torch intra-op threads and miniBatchSize at startup
+	// Short collection and learning trials are run for each combination, and the one with the highest estimated overall steps/second is used
+	struct AutotuneConfig {
+		bool enabled = false;
+
+		// Search grid, leave a list empty to keep the current value
+		std::vector<int> numGames = { 128, 256, 512, 1024 };
+		std::vector<int> numThreads = {}; // Env thread pool sizes
+		std::vector<int> torchThreads = {}; // Torch intra-op thread counts
+		std::vector<int64_t> miniBatchSizes = {}; // Only used on GPU, the CPU learns each batch at once anyway
+
+		int trialWarmupSteps = 5;
+		int trialSteps = 40; // Collection steps timed per trial
+		int64_t trialLearnSamples = 20'000; // Samples learned from per learning trial
+
+		// Configurations whose estimated process memory usage is above this are skipped, set to 0 for no limit
+		// This is estimated from the memory used by the env, rollout storage is not included
+		int64_t maxMemoryMB = 0;
+
+		// Results are cached per host (and per model/config), so calibration only happens once per machine
+		// Set empty to disable caching
+		std::filesystem::path cachePath = "autotune_cache.json";
+	};
+}
@@ -6,16 +6,25 @@
 #include <torch/cuda.h>
 #include <nlohmann/json.hpp>
 #include <pybind11/embed.h>
+#include <future>
 
 #ifdef RG_CUDA_SUPPORT
 #include <c10/cuda/CUDACachingAllocator.h>
+#include <cuda_runtime_api.h>
 #endif
 #include <private/GigaLearnCPP/PPO/ExperienceBuffer.h>
 #include <private/GigaLearnCPP/PPO/GAE.h>
+#include <private/GigaLearnCPP/PPO/RolloutStorage.h>
 #include <private/GigaLearnCPP/PolicyVersionManager.h>
+#include <private/GigaLearnCPP/Autotuner.h>
+#include <private/GigaLearnCPP/Distributed/RolloutServer.h>
+#include <private/GigaLearnCPP/Distributed/RolloutClient.h>
 
 #include "Util/KeyPressDetector.h"
 #include <private/GigaLearnCPP/Util/WelfordStat.h>
+#include <private/GigaLearnCPP/Util/CheckpointWriter.h>
+#include <private/GigaLearnCPP/Util/PackedCheckpoint.h>
+#include <RLGymCPP/Tracer.h>
 #include "Util/AvgTracker.h"
 
 using namespace RLGC;
@@ -38,7 +47,7 @@ GGL::Learner::Learner(EnvCreateFn envCreateFn, LearnerConfig config, StepCallbac
 	RG_LOG("Learner::Learner():");
 
 	if (config.randomSeed == -1)
-		config.randomSeed = RS_CUR_MS();
+		this->config.randomSeed = config.randomSeed = RS_CUR_MS(); // Start() also seeds from this
 
 	RG_LOG("\tCheckpoint Save/Load Dir: " << config.checkpointFolder);
 
@@ -88,7 +97,14 @@ GGL::Learner::Learner(EnvCreateFn envCreateFn, LearnerConfig config, StepCallbac
 		envSetConfig.actionDelay = config.actionDelay;
 		envSetConfig.saveRewards = config.addRewardsToMetrics;
 		envSetConfig.scenarioProvider = config.scenarioProvider;
+		envSetConfig.numShards = config.renderMode ? 1 : config.numEnvShards;
+		envSetConfig.randomSeed = config.randomSeed;
+		envSetConfig.buildMirroredObs = config.mirrorAugment && !config.renderMode;
+		uint64_t memoryBefore = Utils::GetProcessMemoryUsage();
 		envSet = new RLGC::EnvSet(envSetConfig);
+		uint64_t memoryAfter = Utils::GetProcessMemoryUsage();
+		if (memoryAfter > memoryBefore)
+			envMemoryPerArena = (double)(memoryAfter - memoryBefore) / envSetConfig.numArenas;
 		obsSize = envSet->state.obs.size[1];
 		numActions = envSet->actionParsers[0]->GetActionAmount();
 	}
@@ -114,6 +130,39 @@ GGL::Learner::Learner(EnvCreateFn envCreateFn, LearnerConfig config, StepCallbac
 		RG_ERR_CLOSE("Failed to create PPO learner: " << e.what());
 	}
 
+	if (config.autotune.enabled && !config.renderMode) {
+		// Free the envs first, the trials make their own
+		RLGC::EnvSetConfig envSetConfig = envSet->config;
+		delete envSet;
+
+		AutotuneResult result = Autotuner::Run(config, envSetConfig, ppo, obsSize, numActions);
+
+		this->config.numGames = config.numGames = result.numGames;
+		RLGC::g_ThreadPool.Resize(result.numThreads);
+		torch::set_num_threads(result.torchThreads);
+		this->config.ppo.miniBatchSize = config.ppo.miniBatchSize = ppo->config.miniBatchSize = result.miniBatchSize;
+
+		// NOTE: envMemoryPerArena is kept from the first envs, as the new ones may reuse memory freed by the trials
+		RG_LOG("\tRecreating envs...");
+		envSetConfig.numArenas = result.numGames;
+		envSet = new RLGC::EnvSet(envSetConfig);
+	}
+
+#ifdef RG_CUDA_SUPPORT
+	if (device.is_cuda()) {
+		// Page-lock the env obs/mask buffers so uploading them to the GPU doesn't need to be staged by the driver
+		auto& envState = envSet->state;
+		envStateMemPinned =
+			cudaHostRegister(envState.obs.data.data(), envState.obs.data.size() * sizeof(float), cudaHostRegisterDefault) == cudaSuccess &&
+			cudaHostRegister(envState.actionMasks.data.data(), envState.actionMasks.data.size() * sizeof(uint8_t), cudaHostRegisterDefault) == cudaSuccess;
+
+		if (!envStateMemPinned) {
+			RG_LOG("	WARNING: Failed to pin env state memory, GPU uploads will be slower");
+			cudaGetLastError(); // Clear the error
+		}
+	}
+#endif
+
 	if (!config.loadPretrainedModelPath.empty()) {
 		if (std::filesystem::exists(config.loadPretrainedModelPath) && std::filesystem::is_directory(config.loadPretrainedModelPath)) {
 			RG_LOG("\tLoading pretrained model from " << config.loadPretrainedModelPath);
@@ -139,6 +188,7 @@ GGL::Learner::Learner(EnvCreateFn envCreateFn, LearnerConfig config, StepCallbac
 			config.checkpointFolder / "policy_versions", config.maxOldVersions, config.tsPerVersion,
 			config.skillTracker, envSet->config
 		);
+		versionMgr->packedSaves = config.packedCheckpoints;
 	} else {
 		versionMgr = NULL;
 	}
@@ -146,6 +196,25 @@ GGL::Learner::Learner(EnvCreateFn envCreateFn, LearnerConfig config, StepCallbac
 	if (!config.checkpointFolder.empty())
 		Load();
 
+	if (obsStat) {
+		obsStandardizer = new RLGC::ObsStandardizer(obsSize, envSet->arenas.size(), config.minObsSTD, config.maxObsMeanRange);
+		obsStandardizer->SetStats(obsStat->GetMean(), obsStat->GetSTD());
+		obsStandardizer->accumulate = !config.renderMode;
+		envSet->obsStandardizer = obsStandardizer;
+
+		// Standardize the obs from the initial arena resets
+		for (int i = 0; i < envSet->arenas.size(); i++) {
+			int playerStartIdx = envSet->state.arenaPlayerStartIdx[i];
+			for (int j = 0; j < envSet->state.gameStates[i].players.size(); j++) {
+				obsStandardizer->Apply(i, &envSet->state.obs.At(playerStartIdx + j, 0));
+				if (envSet->config.buildMirroredObs)
+					obsStandardizer->Apply(i, &envSet->state.mirrorObs.At(playerStartIdx + j, 0));
+			}
+		}
+	} else {
+		obsStandardizer = NULL;
+	}
+
 	if (config.savePolicyVersions && !config.renderMode) {
 		if (config.checkpointFolder.empty())
 			RG_ERR_CLOSE("Cannot save/load old policy versions with no checkpoint save folder");
@@ -161,18 +230,49 @@ GGL::Learner::Learner(EnvCreateFn envCreateFn, LearnerConfig config, StepCallbac
 		metricSender = NULL;
 	}
 
+	if (config.rolloutServerPort && !config.renderMode) {
+		rolloutServer = new RolloutServer(
+			config.rolloutServerBindAddress, config.rolloutServerPort,
+			RolloutChunkLayout{ obsSize, numActions, config.collectCriticValues }
+		);
+	} else {
+		rolloutServer = NULL;
+	}
+
+	if (config.asyncSaving && !config.checkpointFolder.empty()) {
+		checkpointWriter = new CheckpointWriter();
+	} else {
+		checkpointWriter = NULL;
+	}
+
 	RG_LOG(RG_DIVIDER);
 }
 
-void GGL::Learner::SaveStats(std::filesystem::path path) {
-	using namespace nlohmann;
+void GGL::Learner::UpdateObsStandardizer() {
+	std::lock_guard<std::mutex> obsStatLock(obsStatMutex);
+
+	// Merge the samples from every arena into the main stats
+	for (auto& accumulator : obsStandardizer->accumulators) {
+		obsStat->Merge(accumulator.means, accumulator.m2s, accumulator.count);
+		accumulator.Reset();
+	}
+
+	obsStandardizer->SetStats(obsStat->GetMean(), obsStat->GetSTD());
+}
 
+void GGL::Learner::SaveStats(std::filesystem::path path) {
 	constexpr const char* ERROR_PREFIX = "Learner::SaveStats(): ";
 
 	std::ofstream fOut(path);
 	if (!fOut.good())
 		RG_ERR_CLOSE(ERROR_PREFIX << "Can't open file at " << path);
 
+	fOut << SerializeStats();
+}
+
+std::string GGL::Learner::SerializeStats() {
+	using namespace nlohmann;
+
 	json j = {};
 	j["total_timesteps"] = totalTimesteps;
 	j["total_iterations"] = totalIterations;
@@ -182,27 +282,35 @@ void GGL::Learner::SaveStats(std::filesystem::path path) {
 
 	if (returnStat)
 		j["return_stat"] = returnStat->ToJSON();
-	if (obsStat)
+	if (obsStat) {
+		std::lock_guard<std::mutex> obsStatLock(obsStatMutex);
 		j["obs_stat"] = obsStat->ToJSON();
+	}
 
 	if (versionMgr)
 		versionMgr->AddRunningStatsToJSON(j);
 
-	std::string jStr = j.dump(4);
-	fOut << jStr;
+	return j.dump(4);
 }
 
 void GGL::Learner::LoadStats(std::filesystem::path path) {
 	// TODO: Repetitive code, merge repeated code into one function called from both SaveStats() and LoadStats()
 
-	using namespace nlohmann;
 	constexpr const char* ERROR_PREFIX = "Learner::LoadStats(): ";
 
 	std::ifstream fIn(path);
 	if (!fIn.good())
 		RG_ERR_CLOSE(ERROR_PREFIX << "Can't open file at " << path);
 
-	json j = json::parse(fIn);
+	std::stringstream stream;
+	stream << fIn.rdbuf();
+	DeserializeStats(stream.str());
+}
+
+void GGL::Learner::DeserializeStats(const std::string& jsonStr) {
+	using namespace nlohmann;
+
+	json j = json::parse(jsonStr);
 	totalTimesteps = j["total_timesteps"];
 	totalIterations = j["total_iterations"];
 
@@ -225,35 +333,60 @@ void GGL::Learner::Save() {
 	if (config.checkpointFolder.empty())
 		RG_ERR_CLOSE("Learner::Save(): Cannot save because config.checkpointSaveFolder is not set");
 
+	RG_TRACE_SCOPE("Save");
 	std::filesystem::path saveFolder = config.checkpointFolder / std::to_string(totalTimesteps);
-	std::filesystem::create_directories(saveFolder);
 
 	RG_LOG("Saving to folder " << saveFolder << "...");
-	SaveStats(saveFolder / STATS_FILE_NAME);
-	ppo->SaveTo(saveFolder);
-
-	// Remove old checkpoints
-	if (config.checkpointsToKeep != -1) {
-		std::set<int64_t> allSavedTimesteps = Utils::FindNumberedDirs(config.checkpointFolder);
-		while (allSavedTimesteps.size() > config.checkpointsToKeep) {
-			int64_t lowestCheckpointTS = INT64_MAX;
-			for (int64_t savedTimesteps : allSavedTimesteps)
-				lowestCheckpointTS = RS_MIN(lowestCheckpointTS, savedTimesteps);
-
-			std::filesystem::path removePath = config.checkpointFolder / std::to_string(lowestCheckpointTS);
-			try {
-				std::filesystem::remove_all(removePath);
-			} catch (std::exception& e) {
-				RG_ERR_CLOSE("Failed to remove old checkpoint from " << removePath << ", exception: " << e.what());
+
+	// Everything is copied into memory here, so training can continue while the writer thread writes it
+	CheckpointWriter::Job job = {};
+	job.folder = saveFolder;
+	if (config.packedCheckpoints) {
+		PackedCheckpoint packed = {};
+		ppo->models.AddToPacked(packed);
+		packed.meta = SerializeStats();
+		job.files.push_back({ PackedCheckpoint::FILE_NAME, packed.Serialize() });
+	} else {
+		job.files.push_back({ STATS_FILE_NAME, SerializeStats() });
+		ppo->models.Serialize(job.files);
+	}
+
+	// Remove old checkpoints once the new one is written
+	std::filesystem::path checkpointFolder = config.checkpointFolder;
+	int checkpointsToKeep = config.checkpointsToKeep;
+	if (checkpointsToKeep != -1) {
+		job.onWritten = [checkpointFolder, checkpointsToKeep]() {
+			std::set<int64_t> allSavedTimesteps = Utils::FindNumberedDirs(checkpointFolder);
+			while (allSavedTimesteps.size() > checkpointsToKeep) {
+				int64_t lowestCheckpointTS = INT64_MAX;
+				for (int64_t savedTimesteps : allSavedTimesteps)
+					lowestCheckpointTS = RS_MIN(lowestCheckpointTS, savedTimesteps);
+
+				std::filesystem::path removePath = checkpointFolder / std::to_string(lowestCheckpointTS);
+				try {
+					std::filesystem::remove_all(removePath);
+				} catch (std::exception& e) {
+					RG_ERR_CLOSE("Failed to remove old checkpoint from " << removePath << ", exception: " << e.what());
+				}
+				allSavedTimesteps.erase(lowestCheckpointTS);
 			}
-			allSavedTimesteps.erase(lowestCheckpointTS);
-		}
+		};
+	}
+
+	if (checkpointWriter) {
+		checkpointWriter->Queue(std::move(job));
+	} else {
+		CheckpointWriter::WriteJob(job);
 	}
 
 	if (versionMgr)
-		versionMgr->SaveVersions();
+		versionMgr->SaveVersions(checkpointWriter);
 
-	RG_LOG(" > Done.");
+	if (checkpointWriter) {
+		RG_LOG(" > Queued, writing in the background.");
+	} else {
+		RG_LOG(" > Done.");
+	}
 }
 
 void GGL::Learner::Load() {
@@ -270,7 +403,11 @@ void GGL::Learner::Load() {
 	if (highest != -1) {
 		std::filesystem::path loadFolder = config.checkpointFolder / std::to_string(highest);
 		RG_LOG(" > Loading checkpoint " << loadFolder << "...");
-		LoadStats(loadFolder / STATS_FILE_NAME);
+		if (PackedCheckpoint::ExistsIn(loadFolder)) {
+			DeserializeStats(PackedCheckpoint::Load(loadFolder / PackedCheckpoint::FILE_NAME).meta);
+		} else {
+			LoadStats(loadFolder / STATS_FILE_NAME);
+		}
 		ppo->LoadFrom(loadFolder);
 		RG_LOG(" > Done.");
 	} else {
@@ -278,6 +415,63 @@ void GGL::Learner::Load() {
 	}
 }
 
+void GGL::Learner::ConvertCheckpointsToPacked() {
+	if (config.checkpointFolder.empty())
+		RG_ERR_CLOSE("Learner::ConvertCheckpointsToPacked(): Cannot convert because config.checkpointFolder is not set");
+
+	RG_LOG("Converting checkpoints in " << config.checkpointFolder << " to packed checkpoints...");
+
+	if (checkpointWriter)
+		checkpointWriter->WaitUntilIdle();
+
+	// Load into copies so the current models are untouched
+	ModelSet tempModels = ppo->models.CloneAll();
+
+	int numConverted = 0;
+	for (int64_t timesteps : Utils::FindNumberedDirs(config.checkpointFolder)) {
+		std::filesystem::path folder = config.checkpointFolder / std::to_string(timesteps);
+		if (PackedCheckpoint::ExistsIn(folder))
+			continue;
+
+		RG_LOG(" > Converting " << folder << "...");
+
+		std::ifstream statsIn(folder / STATS_FILE_NAME);
+		if (!statsIn.good())
+			RG_ERR_CLOSE("Learner::ConvertCheckpointsToPacked(): Can't open " << (folder / STATS_FILE_NAME));
+		std::stringstream statsStream;
+		statsStream << statsIn.rdbuf();
+		statsIn.close();
+
+		tempModels.Load(folder, false, true);
+
+		PackedCheckpoint packed = {};
+		tempModels.AddToPacked(packed);
+		packed.meta = statsStream.str();
+
+		// Replaces the whole folder, so the old files are removed
+		CheckpointWriter::Job job = {};
+		job.folder = folder;
+		job.files.push_back({ PackedCheckpoint::FILE_NAME, packed.Serialize() });
+		CheckpointWriter::WriteJob(job);
+		numConverted++;
+	}
+
+	tempModels.Free();
+
+	config.packedCheckpoints = true;
+
+	if (versionMgr) {
+		// Versions are already loaded, so just save them all again
+		versionMgr->packedSaves = true;
+		for (auto& version : versionMgr->versions)
+			version.saved = false;
+		versionMgr->SaveVersions();
+		RG_LOG(" > Converted " << versionMgr->versions.size() << " policy version(s)");
+	}
+
+	RG_LOG(" > Converted " << numConverted << " checkpoint(s)");
+}
+
 void GGL::Learner::StartQuitKeyThread(bool& quitPressed, std::thread& outThread) {
 	quitPressed = false;
 
@@ -296,6 +490,19 @@ void GGL::Learner::StartQuitKeyThread(bool& quitPressed, std::thread& outThread)
 
 	outThread.detach();
 }
+void GGL::Learner::StartRolloutWorker(const std::string& host, int port) {
+	if (config.renderMode)
+		RG_ERR_CLOSE("Learner::StartRolloutWorker(): Cannot run a rollout worker in render mode");
+
+	rolloutClient = new RolloutClient(host, port);
+
+	// Obs stats come from the learner
+	if (obsStandardizer)
+		obsStandardizer->accumulate = false;
+
+	Start();
+}
+
 void GGL::Learner::StartTransferLearn(const TransferLearnConfig& tlConfig) {
 
 	RG_LOG("Starting transfer learning...");
@@ -397,7 +604,8 @@ void GGL::Learner::StartTransferLearn(const TransferLearnConfig& tlConfig) {
 						&tActions, &tLogProbs
 					);
 
-					auto curActions = TENSOR_TO_VEC<int>(tActions);
+					auto& curActions = envSet->state.actions;
+					TENSOR_TO_VEC<int>(tActions, curActions);
 
 					envSet->Sync();
 					envSet->StepSecondHalf(curActions, false);
@@ -433,6 +641,8 @@ void GGL::Learner::StartTransferLearn(const TransferLearnConfig& tlConfig) {
 			if (saveQueued) {
 				if (!config.checkpointFolder.empty())
 					Save();
+				if (checkpointWriter)
+					checkpointWriter->WaitUntilIdle();
 				exit(0);
 			}
 
@@ -480,279 +690,790 @@ void GGL::Learner::Start() {
 	if (render)
 		RG_LOG("\t(Render mode enabled)");
 
+	RG_ASSERT(config.collectionPolicyLag >= 0 && config.collectionPolicyLag <= 1);
+	bool pipelined = (config.collectionPolicyLag > 0) && !render && !rolloutClient;
+	if (pipelined)
+		RG_LOG("\t(Pipelined collection enabled, policy lag: " << config.collectionPolicyLag << ")");
+
 	try {
 		bool saveQueued;
 		std::thread keyPressThread;
 		StartQuitKeyThread(saveQueued, keyPressThread);
 
 		ExperienceBuffer experience = ExperienceBuffer(config.randomSeed, torch::kCPU);
+		experience.lazyBatches = config.ppo.lazyBatches;
 
 		int numPlayers = envSet->state.numPlayers;
 
-		struct Trajectory {
-			FList states, nextStates, rewards, logProbs;
-			std::vector<uint8_t> actionMasks;
-			std::vector<int8_t> terminals;
-			std::vector<int32_t> actions;
+		// With mirror augmentation, the mirrored version of player i is stored as rollout player (numPlayers + i)
+		bool mirror = envSet->config.buildMirroredObs;
+		int numRolloutPlayers = mirror ? (numPlayers * 2) : numPlayers;
 
-			void Clear() {
-				*this = Trajectory();
-			}
+		int maxEpisodeLength = (int)(config.ppo.maxEpisodeDuration * (120.f / config.tickSkip));
+
+		// Collection alternates between two rollout storages, so one can be learned from while the other is collected into
+		// Episodes that are still in progress when collection ends are carried over to the other storage
+		RolloutStorage rolloutStorages[2];
+		int curRolloutStorage = 0;
+		if (!render) {
+			int64_t stepsPerPlayer = RS_MAX(config.ppo.tsPerItr / numRolloutPlayers, 1);
+			int64_t rolloutCapacity = RS_MIN(stepsPerPlayer * 2, stepsPerPlayer + maxEpisodeLength) + 1;
+			for (auto& rolloutStorage : rolloutStorages)
+				rolloutStorage = RolloutStorage(numRolloutPlayers, obsSize, numActions, rolloutCapacity);
+		}
+
+		struct CollectionResult {
+			RolloutStorage* rollouts = NULL; // Complete episodes are committed, in-progress ones are carried over next collection
+			Report report = {};
+			int stepsCollected = 0; // Env steps, so mirrored samples aren't included
+			float collectionTime = 0;
+		};
 
-			void Append(const Trajectory& other) {
-				states += other.states;
-				nextStates += other.nextStates;
-				rewards += other.rewards;
-				logProbs += other.logProbs;
-				actionMasks += other.actionMasks;
-				terminals += other.terminals;
-				actions += other.actions;
+		// The env's arena step callback is set by each collection (see fnCollect)
+		if (arenaStepCallback)
+			arenaReports.resize(envSet->arenas.size());
+
+		// Old policy versions that arenas can be assigned as opponents
+		struct OpponentPool {
+			std::vector<uint64_t> versionTimesteps;
+			std::vector<ModelSet*> models;
+		};
+		OpponentPool opponentPool = {};
+		std::map<uint64_t, ModelSet> opponentModelCache = {}; // Clones of the versions, used if pipelined
+
+		// Updates the opponent pool from the version manager, or returns NULL if we aren't training against old versions
+		// If clone is true, the pool uses cached clones of the versions, so versions can be added/removed while collecting
+		//	Must not be called while a collection is running
+		auto fnUpdateOpponentPool = [&](bool clone) -> OpponentPool* {
+			if (!config.trainAgainstOldVersions || render || rolloutClient)
+				return NULL;
+
+			if (clone) {
+				// Free clones of removed versions
+				for (auto itr = opponentModelCache.begin(); itr != opponentModelCache.end();) {
+					bool stillExists = false;
+					for (auto& version : versionMgr->versions)
+						stillExists |= (version.timesteps == itr->first);
+
+					if (stillExists) {
+						itr++;
+					} else {
+						itr->second.Free();
+						itr = opponentModelCache.erase(itr);
+					}
+				}
 			}
 
-			size_t Length() const {
-				return actions.size();
+			opponentPool = {};
+			for (auto& version : versionMgr->versions) {
+				ModelSet* models = &version.models;
+				if (clone) {
+					ModelSet& cached = opponentModelCache[version.timesteps];
+					if (cached.map.empty())
+						cached = version.models.CloneAll();
+					models = &cached;
+				}
+
+				opponentPool.versionTimesteps.push_back(version.timesteps);
+				opponentPool.models.push_back(models);
 			}
+			return &opponentPool;
 		};
 
-		auto trajectories = std::vector<Trajectory>(numPlayers, Trajectory{});
-		int maxEpisodeLength = (int)(config.ppo.maxEpisodeDuration * (120.f / config.tickSkip));
+		// Opponent of each arena, which controls one team
+		// These persist across iterations, and are only re-rolled when the arena's episode ends
+		struct ArenaOpponent {
+			bool active = false;
+			uint64_t versionTimesteps;
+			Team team;
+		};
+		auto arenaOpponents = std::vector<ArenaOpponent>(envSet->arenas.size());
+		bool arenaOpponentsRolled = false;
+
+		// For choosing which rewards to sample into the metrics, a separate stream from the arenas'
+		PhiloxRNG metricsRNG = PhiloxRNG(config.randomSeed, UINT64_MAX);
+
+		// Metric of each reward of each arena
+		auto rewardMetricIDs = std::vector<std::vector<MetricID>>(envSet->arenas.size());
+		for (int arenaIdx = 0; arenaIdx < envSet->arenas.size(); arenaIdx++)
+			for (auto& weightedReward : envSet->rewards[arenaIdx])
+				rewardMetricIDs[arenaIdx].push_back(MetricRegistry::Register("Rewards/" + weightedReward.reward->GetName()));
+
+		// Collects one iteration of experience
+		// If policyModels is NULL, ppo->models will be used
+		// If opponents is not NULL, arenas will randomly have a team controlled by one of the opponents
+		// If GAE is streamed, returnStd is used to standardize the rewards
+		auto fnCollect = [&](ModelSet* policyModels, OpponentPool* opponents, float returnStd) -> CollectionResult {
+			CollectionResult result = {};
+			Report& report = result.report;
+			int& stepsCollected = result.stepsCollected;
+
+			RolloutStorage& rollouts = rolloutStorages[curRolloutStorage];
+			curRolloutStorage = !curRolloutStorage;
+			if (!render)
+				rollouts.CarryOverFrom(rolloutStorages[curRolloutStorage]);
+			result.rollouts = &rollouts;
+
+			rollouts.streamGAE = config.streamGAE && config.collectCriticValues && !render && !rolloutClient;
+			rollouts.gaeSettings = { config.ppo.gaeGamma, config.ppo.gaeLambda, returnStd, config.ppo.rewardClipRange };
+
+			int numArenas = envSet->arenas.size();
+			int numShards = envSet->shards.size();
+
+			// Model group of every player, -1 is the current policy, otherwise an index into the opponent pool
+			// Only players in group -1 are added to the rollouts
+			auto playerGroups = std::vector<int>(numPlayers, -1);
+
+			// Players of each shard grouped by model, so each model gets one forward per shard
+			// If a group has every player in the shard, its indices are left undefined
+			struct ShardGroup {
+				int group;
+				torch::Tensor tIndices;
+			};
+			auto shardGroups = std::vector<std::vector<ShardGroup>>(numShards);
+			auto shardGroupsOutdated = std::vector<bool>(numShards, true);
+
+			auto fnRollOpponent = [&](int arenaIdx) {
+				RG_ASSERT(config.trainAgainstOldChance >= 0 && config.trainAgainstOldChance <= 1);
 
-		while (true) {
-			Report report = {};
+				// Only called between steps, so the arena's generator is free to use
+				PhiloxRNG& rng = envSet->arenaRNGs[arenaIdx];
 
-			bool isFirstIteration = (totalTimesteps == 0);
+				auto& opponent = arenaOpponents[arenaIdx];
+				opponent.active =
+					opponents && !opponents->models.empty()
+					&& (rng.RandFloat() < config.trainAgainstOldChance);
 
-			// TODO: Old version switching messes up the gameplay potentially
-			GGL::PolicyVersion* oldVersion = NULL;
-			std::vector<bool> oldVersionPlayerMask;
-			std::vector<int> newPlayerIndices = {}, oldPlayerIndices = {};
-			torch::Tensor tNewPlayerIndices, tOldPlayerIndices;
+				if (opponent.active) {
+					opponent.versionTimesteps = opponents->versionTimesteps[rng.RandInt(0, opponents->models.size())];
+					opponent.team = Team(rng.RandInt(0, 2));
+				}
+			};
 
-			for (int i = 0; i < numPlayers; i++)
-				newPlayerIndices.push_back(i);
+			auto fnUpdateArenaGroups = [&](int arenaIdx) {
+				auto& opponent = arenaOpponents[arenaIdx];
 
-			if (config.trainAgainstOldVersions) {
-				RG_ASSERT(config.trainAgainstOldChance >= 0 && config.trainAgainstOldChance <= 1);
-				bool shouldTrainAgainstOld =
-					(RocketSim::Math::RandFloat() < config.trainAgainstOldChance)
-					&& !versionMgr->versions.empty()
-					&& !render;
+				int group = -1;
+				if (opponent.active && opponents && !opponents->models.empty()) {
+					auto& versionTimesteps = opponents->versionTimesteps;
+					auto itr = std::find(versionTimesteps.begin(), versionTimesteps.end(), opponent.versionTimesteps);
+					if (itr != versionTimesteps.end()) {
+						group = itr - versionTimesteps.begin();
+					} else {
+						// Version was removed, switch to another without changing the team
+						// (changing which players are ours mid-episode would leave their episodes unfinished)
+						group = envSet->arenaRNGs[arenaIdx].RandInt(0, versionTimesteps.size());
+						opponent.versionTimesteps = versionTimesteps[group];
+					}
+				} else {
+					opponent.active = false;
+				}
 
-				if (shouldTrainAgainstOld) {
-					// Set up training against old versions
+				int playerStartIdx = envSet->state.arenaPlayerStartIdx[arenaIdx];
+				auto& players = envSet->state.gameStates[arenaIdx].players;
+				for (int i = 0; i < players.size(); i++) {
+					int playerIdx = playerStartIdx + i;
+					int newGroup = (group != -1 && players[i].team == opponent.team) ? group : -1;
+					if (playerGroups[playerIdx] != newGroup) {
+						playerGroups[playerIdx] = newGroup;
+						for (int shardIdx = 0; shardIdx < numShards; shardIdx++)
+							if (playerIdx >= envSet->shards[shardIdx].playerStart && playerIdx < envSet->shards[shardIdx].playerEnd)
+								shardGroupsOutdated[shardIdx] = true;
+					}
+				}
+			};
+
+			auto fnUpdateShardGroups = [&](int shardIdx) {
+				auto& shard = envSet->shards[shardIdx];
+
+				std::map<int, std::vector<int64_t>> groupIndices = {};
+				for (int playerIdx = shard.playerStart; playerIdx < shard.playerEnd; playerIdx++)
+					groupIndices[playerGroups[playerIdx]].push_back(playerIdx - shard.playerStart);
+
+				auto& groups = shardGroups[shardIdx];
+				groups.clear();
+				for (auto& pair : groupIndices) {
+					ShardGroup group = { pair.first };
+					if (pair.second.size() != shard.GetNumPlayers())
+						group.tIndices = torch::tensor(pair.second, torch::kInt64);
+					groups.push_back(group);
+				}
 
-					int oldVersionIdx = RocketSim::Math::RandInt(0, versionMgr->versions.size());
-					oldVersion = &versionMgr->versions[oldVersionIdx];
+				shardGroupsOutdated[shardIdx] = false;
+			};
 
-					Team oldVersionTeam = Team(RocketSim::Math::RandInt(0, 2)); 
-					
-					newPlayerIndices.clear();
-					oldVersionPlayerMask.resize(numPlayers);
-					int i = 0;
-					for (auto& state : envSet->state.gameStates) {
-						for (auto& player : state.players) {
-							if (player.team == oldVersionTeam) {
-								oldVersionPlayerMask[i] = true;
-								oldPlayerIndices.push_back(i);
-							} else {
-								oldVersionPlayerMask[i] = false;
-								newPlayerIndices.push_back(i);
-							}
-							i++;
-						}
+			if (opponents && !arenaOpponentsRolled) {
+				for (int i = 0; i < numArenas; i++)
+					fnRollOpponent(i);
+				arenaOpponentsRolled = true;
+			}
+
+			// The pool may have changed since last collection
+			for (int i = 0; i < numArenas; i++)
+				fnUpdateArenaGroups(i);
+
+			auto& curActions = envSet->state.actions;
+			auto curLogProbs = FList(numPlayers, 0);
+			auto curValues = FList(numPlayers, 0); // Only set if config.collectCriticValues
+
+			// Mirrored steps take the mirror of the chosen action, only set if mirroring
+			auto mirrorActions = IList(numPlayers, 0);
+			auto mirrorLogProbs = FList(numPlayers, 0);
+			auto mirrorValues = FList(numPlayers, 0);
+
+			// Finishes the step of each of the arena's policy players in the rollouts
+			// Called from inside the arena's step job, which only touches the rollouts of its own players
+			auto fnEndArenaSteps = [&](int arenaIdx, bool mirrored) {
+				uint8_t arenaTerminalType = envSet->state.terminals[arenaIdx];
+				int playerStartIdx = envSet->state.arenaPlayerStartIdx[arenaIdx];
+				int playerEndIdx = playerStartIdx + envSet->state.gameStates[arenaIdx].players.size();
+				for (int playerIdx = playerStartIdx; playerIdx < playerEndIdx; playerIdx++) {
+					if (playerGroups[playerIdx] != -1)
+						continue;
+
+					int rolloutPlayerIdx = mirrored ? (numPlayers + playerIdx) : playerIdx;
+
+					int8_t terminalType = arenaTerminalType;
+					if (!terminalType && rollouts.GetEpisodeLength(rolloutPlayerIdx) + 1 >= maxEpisodeLength) {
+						// Episode is too long, truncate it here
+						// This won't actually reset the env, but rather will just add it to experience buffer as truncated
+						terminalType = RLGC::TerminalType::TRUNCATED;
 					}
 
-					tNewPlayerIndices = torch::tensor(newPlayerIndices);
-					tOldPlayerIndices = torch::tensor(oldPlayerIndices);
+					if (mirrored) {
+						// The mirrored episode always has the same length, reward, and terminal
+						rollouts.EndStep(
+							rolloutPlayerIdx, mirrorActions[playerIdx], mirrorLogProbs[playerIdx], mirrorValues[playerIdx], envSet->state.rewards[playerIdx], terminalType,
+							&envSet->state.mirrorObs.At(playerIdx, 0)
+						);
+					} else {
+						rollouts.EndStep(
+							playerIdx, curActions[playerIdx], curLogProbs[playerIdx], curValues[playerIdx], envSet->state.rewards[playerIdx], terminalType,
+							&envSet->state.obs.At(playerIdx, 0)
+						);
+					}
 				}
-			}
+			};
 
-			int numRealPlayers = oldVersion ? newPlayerIndices.size() : envSet->state.numPlayers;
+			envSet->arenaStepCallback = [&](int arenaIdx) {
+				if (arenaStepCallback)
+					arenaStepCallback(this, arenaIdx, envSet->state.gameStates[arenaIdx], arenaReports[arenaIdx]);
 
-			int stepsCollected = 0;
-			{ // Generate experience
+				if (!render)
+					fnEndArenaSteps(arenaIdx, false);
+			};
 
-				// Only contains complete episodes
-				auto combinedTraj = Trajectory();
+			int numOpponentArenas = 0;
+			for (auto& opponent : arenaOpponents)
+				numOpponentArenas += opponent.active;
+			report.AddAvg("Opponent Arena Portion", (float)numOpponentArenas / numArenas);
 
-				Timer collectionTimer = {};
-				{ // Collect timesteps
-					RG_NO_GRAD;
+			Timer collectionTimer = {};
+			{ // Collect timesteps
+				RG_NO_GRAD;
+				RG_TRACE_SCOPE("Collect");
+
+				float inferTime = 0;
+				float envStepTime = 0;
 
-					float inferTime = 0;
-					float envStepTime = 0;
+				// Steps waiting from rollout workers count towards this iteration
+				auto fnGetNumWorkerSteps = [&]() -> int64_t {
+					return rolloutServer ? rolloutServer->GetNumPendingSteps() : 0;
+				};
 
-					for (int step = 0; combinedTraj.Length() < config.ppo.tsPerItr || render; step++, stepsCollected += numRealPlayers) {
-						Timer stepTimer = {};
+				for (int step = 0; rollouts.numCommitted + fnGetNumWorkerSteps() < config.ppo.tsPerItr || render; step++) {
+					RG_TRACE_SCOPE("Collection Step", step);
+
+					Timer stepTimer = {};
+					{
+						RG_TRACE_SCOPE("Reset Arenas");
 						envSet->Reset();
-						envStepTime += stepTimer.Elapsed();
+					}
+					envStepTime += stepTimer.Elapsed();
 
-						for (float f : envSet->state.obs.data)
+					for (float f : envSet->state.obs.data)
+						if (isnan(f) || isinf(f))
+							RG_ERR_CLOSE("Obs builder produced a NaN/inf value");
+					if (mirror)
+						for (float f : envSet->state.mirrorObs.data)
 							if (isnan(f) || isinf(f))
-								RG_ERR_CLOSE("Obs builder produced a NaN/inf value");
-
-						if (!render && obsStat) {
-							// TODO: This samples from old versions too
-							int numSamples = RS_MAX(envSet->state.numPlayers, config.maxObsSamples);
-							for (int i = 0; i < numSamples; i++) {
-								int idx = Math::RandInt(0, envSet->state.numPlayers);
-								obsStat->IncrementRow(&envSet->state.obs.At(idx, 0));
-							}
+								RG_ERR_CLOSE("Obs builder produced a NaN/inf value for a mirrored state");
 
-							std::vector<double> mean = obsStat->GetMean();
-							std::vector<double> std = obsStat->GetSTD();
-							for (double& f : mean)
-								f = RS_CLAMP(f, -config.maxObsMeanRange, config.maxObsMeanRange);
-							for (double& f : std)
-								f = RS_MAX(f, config.minObsSTD);
-							for (int i = 0; i < envSet->state.numPlayers; i++) {
-								for (int j = 0; j < obsSize; j++) {
-									float& obsVal = envSet->state.obs.At(i, j);
-									obsVal = (obsVal - mean[j]) / std[j];
-								}
-							}
-						}
+					torch::Tensor tStates = DIMLIST2_TO_TENSOR<float>(envSet->state.obs);
+					torch::Tensor tActionMasks = DIMLIST2_TO_TENSOR<uint8_t>(envSet->state.actionMasks);
 
-						torch::Tensor tActions, tLogProbs;
-						torch::Tensor tStates = DIMLIST2_TO_TENSOR<float>(envSet->state.obs);
-						torch::Tensor tActionMasks = DIMLIST2_TO_TENSOR<uint8_t>(envSet->state.actionMasks);
+					if (!render) {
+						for (int playerIdx = 0; playerIdx < numPlayers; playerIdx++) {
+							if (playerGroups[playerIdx] == -1) {
+								rollouts.BeginStep(playerIdx, &envSet->state.obs.At(playerIdx, 0), &envSet->state.actionMasks.At(playerIdx, 0));
+								stepsCollected++;
 
-						if (!render) {
-							for (int newPlayerIdx : newPlayerIndices) {
-								trajectories[newPlayerIdx].states += envSet->state.obs.GetRow(newPlayerIdx);
-								trajectories[newPlayerIdx].actionMasks += envSet->state.actionMasks.GetRow(newPlayerIdx);
+								// Mirrored samples count towards tsPerItr (through numCommitted), but aren't env steps
+								if (mirror)
+									rollouts.BeginStep(numPlayers + playerIdx, &envSet->state.mirrorObs.At(playerIdx, 0), &envSet->state.mirrorActionMasks.At(playerIdx, 0));
 							}
 						}
+					}
+
+					// Copied, as the arenas rebuild the mirrored obs while we infer them
+					torch::Tensor tMirrorStates, tMirrorActionMasks;
+					if (mirror) {
+						tMirrorStates = DIMLIST2_TO_TENSOR<float>(envSet->state.mirrorObs).clone();
+						tMirrorActionMasks = DIMLIST2_TO_TENSOR<uint8_t>(envSet->state.mirrorActionMasks).clone();
+					}
+
+					envSet->StepFirstHalf(true);
 
-						envSet->StepFirstHalf(true);
+					// Infer each shard, then start stepping it while the next one is inferred
+					// With only one shard, this is just inferring everything then stepping everything
+					for (int shardIdx = 0; shardIdx < numShards; shardIdx++) {
+						auto& shard = envSet->shards[shardIdx];
+						int numShardPlayers = shard.GetNumPlayers();
 
+						RG_TRACE_SCOPE("Infer Shard", shardIdx);
 						Timer inferTimer = {};
 
-						if (oldVersion) {
-							torch::Tensor tdNewStates = tStates.index_select(0, tNewPlayerIndices).to(ppo->device, true);
-							torch::Tensor tdOldStates = tStates.index_select(0, tOldPlayerIndices).to(ppo->device, true);
-							torch::Tensor tdNewActionMasks = tActionMasks.index_select(0, tNewPlayerIndices).to(ppo->device, true);
-							torch::Tensor tdOldActionMasks = tActionMasks.index_select(0, tOldPlayerIndices).to(ppo->device, true);
-
-							torch::Tensor tNewActions;
-							torch::Tensor tOldActions;
-
-							ppo->InferActions(tdNewStates, tdNewActionMasks, &tNewActions, &tLogProbs);
-							ppo->InferActions(tdOldStates, tdOldActionMasks, &tOldActions, NULL, &oldVersion->models);
-
-							tActions = torch::zeros(numPlayers, tNewActions.dtype());
-							tActions.index_copy_(0, tNewPlayerIndices, tNewActions.cpu());
-							tActions.index_copy_(0, tOldPlayerIndices, tOldActions.cpu());
-						} else {
-							torch::Tensor tdStates = tStates.to(ppo->device, true);
-							torch::Tensor tdActionMasks = tActionMasks.to(ppo->device, true);
-							ppo->InferActions(tdStates, tdActionMasks, &tActions, &tLogProbs);
-							tActions = tActions.cpu();
+						if (shardGroupsOutdated[shardIdx])
+							fnUpdateShardGroups(shardIdx);
+
+						torch::Tensor tShardStates = tStates.slice(0, shard.playerStart, shard.playerEnd);
+						torch::Tensor tShardActionMasks = tActionMasks.slice(0, shard.playerStart, shard.playerEnd);
+
+						// Outputs are written straight into the env's action list and our log prob list
+						torch::Tensor tShardActionsOut = torch::from_blob(curActions.data() + shard.playerStart, { numShardPlayers }, torch::kInt32);
+						torch::Tensor tShardLogProbsOut = torch::from_blob(curLogProbs.data() + shard.playerStart, { numShardPlayers }, torch::kFloat32);
+						torch::Tensor tShardValuesOut = torch::from_blob(curValues.data() + shard.playerStart, { numShardPlayers }, torch::kFloat32);
+
+						for (auto& group : shardGroups[shardIdx]) {
+							bool isPolicy = (group.group == -1);
+							ModelSet* models = isPolicy ? policyModels : opponents->models[group.group];
+							bool wholeShard = !group.tIndices.defined();
+
+							torch::Tensor tdStates, tdActionMasks;
+							if (wholeShard) {
+								tdStates = tShardStates.to(ppo->device, true);
+								tdActionMasks = tShardActionMasks.to(ppo->device, true);
+							} else {
+								tdStates = tShardStates.index_select(0, group.tIndices).to(ppo->device, true);
+								tdActionMasks = tShardActionMasks.index_select(0, group.tIndices).to(ppo->device, true);
+							}
+
+							torch::Tensor tActions, tLogProbs, tValues;
+							bool needLogProbs = isPolicy && !render;
+							bool needValues = needLogProbs && config.collectCriticValues;
+							if (needValues) {
+								ppo->InferActionsAndValues(tdStates, tdActionMasks, &tActions, &tLogProbs, &tValues, models);
+								tValues = tValues.cpu().to(torch::kFloat32);
+							} else {
+								ppo->InferActions(tdStates, tdActionMasks, &tActions, needLogProbs ? &tLogProbs : NULL, models);
+							}
+							tActions = tActions.cpu().to(torch::kInt32);
+							if (needLogProbs)
+								tLogProbs = tLogProbs.cpu().to(torch::kFloat32);
+
+							if (wholeShard) {
+								tShardActionsOut.copy_(tActions);
+								if (needLogProbs)
+									tShardLogProbsOut.copy_(tLogProbs);
+								if (needValues)
+									tShardValuesOut.copy_(tValues);
+							} else {
+								tShardActionsOut.index_copy_(0, group.tIndices, tActions);
+								if (needLogProbs)
+									tShardLogProbsOut.index_copy_(0, group.tIndices, tLogProbs);
+								if (needValues)
+									tShardValuesOut.index_copy_(0, group.tIndices, tValues);
+							}
 						}
-						inferTime += inferTimer.Elapsed();
 
-						auto curActions = TENSOR_TO_VEC<int>(tActions);
-						FList newLogProbs;
-						if (tLogProbs.defined() && !render)
-							newLogProbs = TENSOR_TO_VEC<float>(tLogProbs);	
+						inferTime += inferTimer.Elapsed();
 
 						stepTimer.Reset();
-						envSet->Sync(); // Make sure the first half is done
-						envSet->StepSecondHalf(curActions, false);
+						envSet->StepShardSecondHalf(shardIdx, curActions, true);
 						envStepTime += stepTimer.Elapsed();
+					}
 
-						if (stepCallback)
-							stepCallback(this, envSet->state.gameStates, report);
+					if (mirror) {
+						// Only the log probs (and values) of the mirrored actions are needed, which we infer while the arenas step
+						// NOTE: Players controlled by opponents are inferred too, but never used
+						RG_TRACE_SCOPE("Infer Mirrored");
+						Timer inferTimer = {};
 
-						if (render) {
-							renderSender->Send(envSet->state.gameStates[0]);
-							continue;
-						}
+						auto& actionMirrorMap = envSet->actionMirrorMap;
+						for (int playerIdx = 0; playerIdx < numPlayers; playerIdx++)
+							mirrorActions[playerIdx] = actionMirrorMap[curActions[playerIdx]];
 
-						// Calc average rewards
-						if (config.addRewardsToMetrics && (Math::RandInt(0, config.rewardSampleRandInterval) == 0)) {
-							int numSamples = RS_MIN(envSet->arenas.size(), config.maxRewardSamples);
-							std::unordered_map<std::string, AvgTracker> avgRewards = {};
-							for (int i = 0; i < numSamples; i++) {
-								int arenaIdx = Math::RandInt(0, envSet->arenas.size());
-								auto& prevRewards = envSet->state.lastRewards[i];
-
-								for (int j = 0; j < envSet->rewards[arenaIdx].size(); j++) {
-									std::string rewardName = envSet->rewards[arenaIdx][j].reward->GetName();
-									avgRewards[rewardName] += prevRewards[j];
-								}
-							}
+						torch::Tensor tMirrorActions = torch::from_blob(mirrorActions.data(), { numPlayers }, torch::kInt32);
+						torch::Tensor tLogProbs, tValues;
+						ppo->InferLogProbsAndValues(
+							tMirrorStates.to(ppo->device, true), tMirrorActionMasks.to(ppo->device, true), tMirrorActions.to(ppo->device, true),
+							&tLogProbs, config.collectCriticValues ? &tValues : NULL, policyModels
+						);
 
-							for (auto& pair : avgRewards)
-								report.AddAvg("Rewards/" + pair.first, pair.second.Get());
-						}
+						torch::from_blob(mirrorLogProbs.data(), { numPlayers }, torch::kFloat32).copy_(tLogProbs.cpu().to(torch::kFloat32));
+						if (config.collectCriticValues)
+							torch::from_blob(mirrorValues.data(), { numPlayers }, torch::kFloat32).copy_(tValues.cpu().to(torch::kFloat32));
 
-						// Now that we've inferred and stepped the env, we can add that stuff to the trajectories
-						int i = 0;
-						for (int newPlayerIdx : newPlayerIndices) {
-							trajectories[newPlayerIdx].actions.push_back(curActions[newPlayerIdx]);
-							trajectories[newPlayerIdx].rewards += envSet->state.rewards[newPlayerIdx];
-							trajectories[newPlayerIdx].logProbs += newLogProbs[i];
-							i++;
-						}
+						inferTime += inferTimer.Elapsed();
+					}
 
-						auto curTerminals = std::vector<uint8_t>(numPlayers, 0);
-						for (int idx = 0; idx < envSet->arenas.size(); idx++) {
-							uint8_t terminalType = envSet->state.terminals[idx];
-							if (!terminalType)
-								continue;
+					stepTimer.Reset();
+					envSet->Sync(); // Wait for all shards to finish stepping
+					envStepTime += stepTimer.Elapsed();
 
-							auto playerStartIdx = envSet->state.arenaPlayerStartIdx[idx];
-							int playersInArena = envSet->state.gameStates[idx].players.size();
-							for (int i = 0; i < playersInArena; i++)
-								curTerminals[playerStartIdx + i] = terminalType;
-						}
+					if (stepCallback)
+						stepCallback(this, envSet->state.gameStates, report);
 
-						for (int newPlayerIdx : newPlayerIndices) {
-							int8_t terminalType = curTerminals[newPlayerIdx];
-							auto& traj = trajectories[newPlayerIdx];
+					if (render) {
+						renderSender->Send(envSet->state.gameStates[0]);
+						continue;
+					}
 
-							if (!terminalType && traj.Length() >= maxEpisodeLength) {
-								// Episode is too long, truncate it here
-								// This won't actually reset the env, but rather will just add it to experience buffer as truncated
-								terminalType = RLGC::TerminalType::TRUNCATED;
-							}
+					// Calc average rewards
+					if (config.addRewardsToMetrics && (metricsRNG.RandInt(0, config.rewardSampleRandInterval) == 0)) {
+						int numSamples = RS_MIN(envSet->arenas.size(), config.maxRewardSamples);
+						for (int i = 0; i < numSamples; i++) {
+							int arenaIdx = metricsRNG.RandInt(0, envSet->arenas.size());
+							auto& prevRewards = envSet->state.lastRewards[arenaIdx];
+							auto& metricIDs = rewardMetricIDs[arenaIdx];
 
-							traj.terminals.push_back(terminalType);
-							if (terminalType) {
+							for (int j = 0; j < prevRewards.size(); j++)
+								report.AddStat(metricIDs[j], prevRewards[j]);
+						}
+					}
 
-								if (terminalType == RLGC::TerminalType::TRUNCATED) {
-									// Truncation requires an additional next state for the critic
-									traj.nextStates += envSet->state.obs.GetRow(newPlayerIdx);
-								}
+					// Mirrored steps are finished separately, as their log probs were inferred after the arenas started stepping
+					if (mirror) {
+						RG_TRACE_SCOPE("End Mirrored Steps");
+						RLGC::g_ThreadPool.StartBatchedJobs([&](int arenaIdx) { fnEndArenaSteps(arenaIdx, true); }, numArenas, false);
+					}
 
-								combinedTraj.Append(traj);
-								traj.Clear();
+					// Arenas that are about to reset get a new opponent
+					if (opponents) {
+						for (int idx = 0; idx < numArenas; idx++) {
+							if (envSet->state.terminals[idx]) {
+								fnRollOpponent(idx);
+								fnUpdateArenaGroups(idx);
 							}
 						}
 					}
+				}
+
+				report["Inference Time"] = inferTime;
+				report["Env Step Time"] = envStepTime;
+			}
+			result.collectionTime = collectionTimer.Elapsed();
+
+			envSet->arenaStepCallback = NULL;
+			if (!render)
+				rollouts.SortCommitted();
+
+			if (obsStandardizer && !render && !rolloutClient)
+				UpdateObsStandardizer();
+
+			// All arena jobs are done, so the arena reports can be safely merged
+			for (auto& arenaReport : arenaReports) {
+				report.Merge(arenaReport);
+				arenaReport = {};
+			}
+
+			// Finish averages now, as the report may be merged into one from another thread
+			report.Finish();
+			return result;
+		};
+
+		// Policy snapshot used by the pipelined collector while the learner updates the real models
+		ModelSet collectionModels = {};
+		if (pipelined)
+			collectionModels = config.collectCriticValues ? ppo->models.CloneAll() : ppo->GetPolicyModels().CloneAll();
+
+		std::future<CollectionResult> pendingCollection = {};
+
+		auto fnMakeRolloutPolicy = [&]() -> RolloutPolicy {
+			RolloutPolicy policy = {};
+			policy.version = totalIterations;
+			ModelSet policyModels = config.collectCriticValues ? ppo->models : ppo->GetPolicyModels();
+			for (auto& pair : policyModels.map)
+				policy.modelParams[pair.first] = pair.second->CopyParams();
+
+			if (obsStat) {
+				std::lock_guard<std::mutex> obsStatLock(obsStatMutex);
+				policy.obsMean = obsStat->GetMean();
+				policy.obsSTD = obsStat->GetSTD();
+			}
+			return policy;
+		};
+
+		if (rolloutClient) {
+			RG_LOG("\t(Running as a rollout worker)");
+
+			uint64_t policyVersion = 0;
+			bool hasPolicy = false;
+			while (true) {
+				if (saveQueued)
+					exit(0);
+
+				// Wait for the first policy, after that just switch to the newest one between collections
+				RolloutPolicy policy;
+				if (rolloutClient->TakeLatestPolicy(policy, !hasPolicy)) {
+					for (auto& pair : policy.modelParams) {
+						Model* model = ppo->models[pair.first];
+						if (!model)
+							RG_ERR_CLOSE("Learner: Received params for unknown model \"" << pair.first << "\" from the learner");
+						model->SetParams(pair.second);
+					}
+
+					if (obsStandardizer && !policy.obsMean.empty())
+						obsStandardizer->SetStats(policy.obsMean, policy.obsSTD);
+
+					policyVersion = policy.version;
+					hasPolicy = true;
+				}
+
+				if (!hasPolicy || !rolloutClient->connected)
+					RG_ERR_CLOSE("Learner: Lost connection to the learner");
+
+				CollectionResult collected = fnCollect(NULL, NULL, 1);
+				RolloutStorage& rollouts = *collected.rollouts;
+
+				torch::Tensor tIndices = rollouts.GetCommittedIndices();
+				RolloutChunk chunk = {};
+				chunk.policyVersion = policyVersion;
+				chunk.states = RolloutStorage::Flatten(rollouts.states).index_select(0, tIndices);
+				chunk.actionMasks = RolloutStorage::Flatten(rollouts.actionMasks).index_select(0, tIndices);
+				chunk.actions = RolloutStorage::Flatten(rollouts.actions).index_select(0, tIndices);
+				chunk.logProbs = RolloutStorage::Flatten(rollouts.logProbs).index_select(0, tIndices);
+				chunk.rewards = RolloutStorage::Flatten(rollouts.rewards).index_select(0, tIndices);
+				chunk.terminals = RolloutStorage::Flatten(rollouts.terminals).index_select(0, tIndices);
+				if (config.collectCriticValues)
+					chunk.values = RolloutStorage::Flatten(rollouts.values).index_select(0, tIndices);
+				chunk.truncNextStates = rollouts.truncNextStates;
+				chunk.stepsCollected = collected.stepsCollected;
+				chunk.collectionTime = collected.collectionTime;
+
+				if (!rolloutClient->SendChunk(chunk))
+					RG_ERR_CLOSE("Learner: Lost connection to the learner");
+
+				RG_LOG(
+					"Sent " << chunk.GetNumSteps() << " steps (policy version " << policyVersion << ", " 
+					<< (int)(chunk.stepsCollected / chunk.collectionTime) << " steps/second)"
+				);
+			}
+		}
+
+		// Workers that connect later will get the newest policy when they connect
+		if (rolloutServer)
+			rolloutServer->BroadcastPolicy(fnMakeRolloutPolicy());
+
+		RLGC::g_Tracer.SetThreadName("Learner");
+
+		// Iterations are counted from the start of this run for tracing
+		int runIterations = 0;
+		auto fnUpdateTracing = [&]() {
+			if (config.traceStartIteration < 0)
+				return;
+
+			if (runIterations == config.traceStartIteration) {
+				RG_LOG("Tracing " << config.traceIterations << " iteration(s)...");
+				RLGC::g_Tracer.Start();
+			} else if (runIterations == config.traceStartIteration + config.traceIterations) {
+				RLGC::g_Tracer.Stop();
+				RLGC::g_Tracer.WriteJSON(config.traceOutputPath);
+				RG_LOG("Wrote trace to " << config.traceOutputPath);
+			}
+		};
+
+		// Adds the memory used by each subsystem to the report, in MB
+		// Must not be called while a collection is running
+		auto fnAddMemoryUsage = [&](Report& report) {
+			constexpr double BYTES_PER_MB = 1024 * 1024;
+
+			double envStateBytes = envSet->state.GetMemoryUsage();
+			report["Memory/Arenas"] = RS_MAX(envMemoryPerArena * envSet->arenas.size() - envStateBytes, 0) / BYTES_PER_MB;
+			report["Memory/Env State"] = envStateBytes / BYTES_PER_MB;
+
+			uint64_t rolloutBytes = 0, experienceBytes = 0;
+			for (auto& rolloutStorage : rolloutStorages)
+				rolloutBytes += rolloutStorage.GetMemoryUsage();
+
+			// Experience is mostly views of the rollout slabs, so only count what was copied out of them
+			for (auto& tensor : experience.scratch)
+				experienceBytes += GetTensorMemoryUsage(tensor);
+			for (auto& tensor : experience.data) {
+				bool isRolloutView = false;
+				for (auto& rolloutStorage : rolloutStorages)
+					for (auto& slab : rolloutStorage.GetSlabs())
+						isRolloutView |= tensor.defined() && slab.defined() && tensor.is_alias_of(slab);
+
+				if (!isRolloutView)
+					experienceBytes += GetTensorMemoryUsage(tensor);
+			}
+			report["Memory/Rollout Storage"] = rolloutBytes / BYTES_PER_MB;
+			report["Memory/Experience"] = experienceBytes / BYTES_PER_MB;
+
+			uint64_t modelBytes = ppo->models.GetMemoryUsage(true) + collectionModels.GetMemoryUsage(false);
+			for (auto& replica : ppo->cpuReplicas)
+				modelBytes += replica.GetMemoryUsage(false);
+			report["Memory/Models"] = modelBytes / BYTES_PER_MB;
+
+			uint64_t oldVersionBytes = versionMgr ? versionMgr->GetMemoryUsage() : 0;
+			for (auto& pair : opponentModelCache)
+				oldVersionBytes += pair.second.GetMemoryUsage(false);
+			report["Memory/Old Versions"] = oldVersionBytes / BYTES_PER_MB;
+
+#ifdef RG_CUDA_SUPPORT
+			if (ppo->device.is_cuda()) {
+				auto stats = c10::cuda::CUDACachingAllocator::getDeviceStats(ppo->device.has_index() ? ppo->device.index() : 0);
+				constexpr size_t AGGREGATE = (size_t)c10::CachingAllocator::StatType::AGGREGATE;
+				report["Memory/Torch CUDA Allocated"] = stats.allocated_bytes[AGGREGATE].current / BYTES_PER_MB;
+				report["Memory/Torch CUDA Reserved"] = stats.reserved_bytes[AGGREGATE].current / BYTES_PER_MB;
+			}
+#endif
+
+			report["Memory/Process"] = Utils::GetProcessMemoryUsage() / BYTES_PER_MB;
+		};
+
+		if (!render) {
+			Report memoryReport = {};
+			fnAddMemoryUsage(memoryReport);
+			RG_LOG("\tMemory usage (MB):");
+			for (auto& pair : std::map<std::string, Report::Val>(memoryReport.data.begin(), memoryReport.data.end()))
+				RG_LOG("\t\t" << memoryReport.SingleToString(pair.first));
+		}
+
+		while (true) {
+			fnUpdateTracing();
+			RG_TRACE_SCOPE("Iteration", totalIterations);
+			runIterations++;
+
+			Report report = {};
+			Timer iterationTimer = {};
+
+			bool isFirstIteration = (totalTimesteps == 0);
+
+			CollectionResult collected;
+			if (pendingCollection.valid()) {
+				// Wait for the collection we started last iteration
+				RG_TRACE_SCOPE("Collection Wait");
+				Timer waitTimer = {};
+				collected = pendingCollection.get();
+				report["Collection Wait Time"] = waitTimer.Elapsed();
+			} else {
+				collected = fnCollect(NULL, fnUpdateOpponentPool(false), returnStat ? returnStat->GetSTD() : 1);
+			}
+
+			// No collection is running until the next one is started below
+			if (!render)
+				fnAddMemoryUsage(report);
+
+			if (pipelined) {
+				// Start collecting the next iteration with a snapshot of the current policy while we learn from this one
+				// The collector's logprobs are recorded against this snapshot, which will be one iteration behind when learned from
+				collectionModels.CopyParamsFrom(ppo->models);
+
+				// Old versions can be added/removed during this iteration, so the collector uses cached clones of them
+				OpponentPool* opponents = fnUpdateOpponentPool(true);
+				float returnStd = returnStat ? returnStat->GetSTD() : 1;
+
+				pendingCollection = std::async(std::launch::async,
+					[&, opponents, returnStd]() {
+						RLGC::g_Tracer.SetThreadName("Collector");
+						return fnCollect(&collectionModels, opponents, returnStd);
+					}
+				);
+			}
+
+			report += collected.report;
+			int stepsCollected = collected.stepsCollected;
+			RolloutStorage& rollouts = *collected.rollouts;
+
+			std::vector<RolloutChunk> workerChunks = {};
+			if (rolloutServer) {
+				int numDiscarded = 0;
+				float totalPolicyLag = 0;
+				std::map<int, std::pair<int64_t, float>> workerCollection = {}; // Steps and time collecting, by worker ID
+				// The server only keeps chunks that match our obs size, action count and critic value setting
+				for (auto& chunk : rolloutServer->TakeChunks()) {
+					uint64_t policyLag = totalIterations - chunk.policyVersion;
+					if (policyLag > config.maxRolloutPolicyLag) {
+						numDiscarded++;
+						continue;
+					}
 
-					report["Inference Time"] = inferTime;
-					report["Env Step Time"] = envStepTime;
+					totalPolicyLag += policyLag;
+					stepsCollected += chunk.stepsCollected;
+					workerCollection[chunk.workerID].first += chunk.stepsCollected;
+					workerCollection[chunk.workerID].second += chunk.collectionTime;
+					workerChunks.push_back(std::move(chunk));
 				}
-				float collectionTime = collectionTimer.Elapsed();
+
+				report["Workers/Connected"] = rolloutServer->GetNumWorkers();
+				report["Workers/Discarded Chunks"] = numDiscarded;
+				report["Workers/Collected Timesteps"] = stepsCollected - collected.stepsCollected;
+				if (!workerChunks.empty())
+					report["Workers/Avg Policy Lag"] = totalPolicyLag / workerChunks.size();
+				for (auto& pair : workerCollection)
+					report[RS_STR("Workers/Worker " << pair.first << " Steps/Second")] = pair.second.first / pair.second.second;
+			}
+
+			{ // Generate experience
+				float collectionTime = collected.collectionTime;
 
 				Timer consumptionTimer = {};
 				{ // Process timesteps
 					RG_NO_GRAD;
+					RG_TRACE_SCOPE("Process Timesteps");
+
+					// Views of the rollout slabs, only the committed indices are valid
+					torch::Tensor tStates = RolloutStorage::Flatten(rollouts.states);
+					torch::Tensor tActionMasks = RolloutStorage::Flatten(rollouts.actionMasks);
+					torch::Tensor tActions = RolloutStorage::Flatten(rollouts.actions);
+					torch::Tensor tLogProbs = RolloutStorage::Flatten(rollouts.logProbs);
+					torch::Tensor tRewards = RolloutStorage::Flatten(rollouts.rewards);
+					torch::Tensor tTerminals = RolloutStorage::Flatten(rollouts.terminals);
+					torch::Tensor tValues = RolloutStorage::Flatten(rollouts.values); // Only valid if config.collectCriticValues
+
+					// Indices of every committed step, in episode order
+					torch::Tensor tIndices = rollouts.GetCommittedIndices();
+
+					const FList* truncNextStates = &rollouts.truncNextStates;
+					FList allTruncNextStates;
+
+					if (!workerChunks.empty()) {
+						// Gather the committed local steps, then append the worker steps after them
+						auto fnGather = [&](torch::Tensor tLocal, torch::Tensor RolloutChunk::* chunkField) {
+							std::vector<torch::Tensor> parts = { tLocal.index_select(0, tIndices) };
+							for (auto& chunk : workerChunks)
+								parts.push_back(chunk.*chunkField);
+							return torch::cat(parts);
+						};
+
+						tStates = fnGather(tStates, &RolloutChunk::states);
+						tActionMasks = fnGather(tActionMasks, &RolloutChunk::actionMasks);
+						tActions = fnGather(tActions, &RolloutChunk::actions);
+						tLogProbs = fnGather(tLogProbs, &RolloutChunk::logProbs);
+						tRewards = fnGather(tRewards, &RolloutChunk::rewards);
+						tTerminals = fnGather(tTerminals, &RolloutChunk::terminals);
+						if (config.collectCriticValues)
+							tValues = fnGather(tValues, &RolloutChunk::values);
+
+						allTruncNextStates = rollouts.truncNextStates;
+						for (auto& chunk : workerChunks)
+							allTruncNextStates += chunk.truncNextStates;
+						truncNextStates = &allTruncNextStates;
+
+						tIndices = torch::arange(tStates.size(0));
+					}
+
+					int64_t numSteps = tIndices.size(0);
 
-					// Make and transpose tensors
-					torch::Tensor tStates = torch::tensor(combinedTraj.states).reshape({ -1, obsSize });
-					torch::Tensor tActionMasks = torch::tensor(combinedTraj.actionMasks).reshape({ -1, numActions });
-					torch::Tensor tActions = torch::tensor(combinedTraj.actions);
-					torch::Tensor tLogProbs = torch::tensor(combinedTraj.logProbs);
-					torch::Tensor tRewards = torch::tensor(combinedTraj.rewards);
-					torch::Tensor tTerminals = torch::tensor(combinedTraj.terminals);
+					tRewards = tRewards.index_select(0, tIndices);
+					tTerminals = tTerminals.index_select(0, tIndices);
 
 					// States we truncated at (there could be none)
 					torch::Tensor tNextTruncStates;
-					if (!combinedTraj.nextStates.empty())
-						tNextTruncStates = torch::tensor(combinedTraj.nextStates).reshape({ -1, obsSize });
+					if (!truncNextStates->empty())
+						tNextTruncStates = torch::tensor(*truncNextStates).reshape({ -1, obsSize });
 
 					report["Average Step Reward"] = tRewards.mean().item<float>();
 					report["Collected Timesteps"] = stepsCollected;
@@ -760,18 +1481,23 @@ void GGL::Learner::Start() {
 					torch::Tensor tValPreds;
 					torch::Tensor tTruncValPreds;
 
-					if (ppo->device.is_cpu()) {
+					if (config.collectCriticValues) {
+						// Values were already inferred during collection, only the truncated next states need the critic
+						tValPreds = tValues.index_select(0, tIndices);
+						if (tNextTruncStates.defined())
+							tTruncValPreds = ppo->InferCritic(tNextTruncStates.to(ppo->device, true, true)).cpu();
+					} else if (ppo->device.is_cpu()) {
 						// Predict values all at once
-						tValPreds = ppo->InferCritic(tStates.to(ppo->device, true, true)).cpu();
+						tValPreds = ppo->InferCritic(tStates.index_select(0, tIndices)).cpu();
 						if (tNextTruncStates.defined())
 							tTruncValPreds = ppo->InferCritic(tNextTruncStates.to(ppo->device, true, true)).cpu();
 					} else {
 						// Predict values using minibatching
-						tValPreds = torch::zeros({ (int64_t)combinedTraj.Length() });
-						for (int i = 0; i < combinedTraj.Length(); i += ppo->config.miniBatchSize) {
-							int start = i;
-							int end = RS_MIN(i + ppo->config.miniBatchSize, combinedTraj.Length());
-							torch::Tensor tStatesPart = tStates.slice(0, start, end);
+						tValPreds = torch::zeros({ numSteps });
+						for (int64_t i = 0; i < numSteps; i += ppo->config.miniBatchSize) {
+							int64_t start = i;
+							int64_t end = RS_MIN(i + ppo->config.miniBatchSize, numSteps);
+							torch::Tensor tStatesPart = tStates.index_select(0, tIndices.slice(0, start, end));
 
 							auto valPredsPart = ppo->InferCritic(tStatesPart.to(ppo->device, true, true)).cpu();
 							RG_ASSERT(valPredsPart.size(0) == (end - start));
@@ -789,15 +1515,27 @@ void GGL::Learner::Start() {
 
 					report["Episode Length"] = 1.f / (tTerminals == 1).to(torch::kFloat32).mean().item<float>();
 
+					RG_TRACE_SCOPE("GAE");
 					Timer gaeTimer = {};
 					// Run GAE
 					torch::Tensor tAdvantages, tTargetVals, tReturns;
 					float rewClipPortion;
-					GAE::Compute(
-						tRewards, tTerminals, tValPreds, tTruncValPreds,
-						tAdvantages, tTargetVals, tReturns, rewClipPortion,
-						config.ppo.gaeGamma, config.ppo.gaeLambda, returnStat ? returnStat->GetSTD() : 1, config.ppo.rewardClipRange
-					);
+					if (rollouts.streamGAE && workerChunks.empty()) {
+						// Most episodes already had GAE run during collection, only truncated ones are left
+						tTruncValPreds = tTruncValPreds.defined() ? tTruncValPreds.to(torch::kFloat32).contiguous() : tTruncValPreds;
+						rollouts.FinishGAE(tTruncValPreds.defined() ? tTruncValPreds.const_data_ptr<float>() : NULL);
+
+						tAdvantages = RolloutStorage::Flatten(rollouts.advantages).index_select(0, tIndices);
+						tReturns = RolloutStorage::Flatten(rollouts.returns).index_select(0, tIndices);
+						tTargetVals = tValPreds + tAdvantages;
+						rewClipPortion = rollouts.GetRewClipPortion();
+					} else {
+						GAE::Compute(
+							tRewards, tTerminals, tValPreds, tTruncValPreds,
+							tAdvantages, tTargetVals, tReturns, rewClipPortion,
+							config.ppo.gaeGamma, config.ppo.gaeLambda, returnStat ? returnStat->GetSTD() : 1, config.ppo.rewardClipRange
+						);
+					}
 					report["GAE Time"] = gaeTimer.Elapsed();
 					report["Clipped Reward Portion"] = rewClipPortion;
 
@@ -815,12 +1553,14 @@ void GGL::Learner::Start() {
 					report["GAE/Avg Val Target"] = tTargetVals.abs().mean().item<float>();
 
 					// Set experience buffer
+					// Advantages and target values are scattered to match the rollout slab layout
+					experience.indices = tIndices;
 					experience.data.actions = tActions;
 					experience.data.logProbs = tLogProbs;
 					experience.data.actionMasks = tActionMasks;
 					experience.data.states = tStates;
-					experience.data.advantages = tAdvantages;
-					experience.data.targetValues = tTargetVals;
+					experience.data.advantages = torch::zeros({ tStates.size(0) }).index_copy_(0, tIndices, tAdvantages);
+					experience.data.targetValues = torch::zeros({ tStates.size(0) }).index_copy_(0, tIndices, tTargetVals);
 				}
 
 				// Free CUDA cache
@@ -829,18 +1569,46 @@ void GGL::Learner::Start() {
 					c10::cuda::CUDACachingAllocator::emptyCache();
 #endif
 
+				float benchmarkTime = 0;
+				if (config.benchmarkMixedPrecision && runIterations == 1) {
+					// Compare on the real experience, with the loaded models, before the real update
+					Timer benchmarkTimer = {};
+					float preLearnTime = consumptionTimer.Elapsed();
+					auto benchmark = ppo->BenchmarkMixedPrecision(experience);
+					benchmarkTime = benchmarkTimer.Elapsed();
+
+					float fp32SPS = stepsCollected / (preLearnTime + benchmark.learnTime[0]);
+					float mixedSPS = stepsCollected / (preLearnTime + benchmark.learnTime[1]);
+					report["Mixed Precision/FP32 Consumption Steps/Second"] = fp32SPS;
+					report["Mixed Precision/BF16 Consumption Steps/Second"] = mixedSPS;
+					report["Mixed Precision/Speedup"] = mixedSPS / fp32SPS;
+					report["Mixed Precision/Update Cosine Similarity"] = benchmark.updateCosSim;
+					RG_LOG(
+						"Mixed precision benchmark: " << (int)fp32SPS << " (fp32) vs " << (int)mixedSPS << " (bf16) consumption steps/second, " <<
+						"update cosine similarity: " << benchmark.updateCosSim
+					);
+				}
+
 				// Learn
 				Timer learnTimer = {};
-				ppo->Learn(experience, report, isFirstIteration);
+				{
+					RG_TRACE_SCOPE("PPO Learn");
+					ppo->Learn(experience, report, isFirstIteration);
+				}
 				report["PPO Learn Time"] = learnTimer.Elapsed();
 
 				// Set metrics
-				float consumptionTime = consumptionTimer.Elapsed();
+				float consumptionTime = consumptionTimer.Elapsed() - benchmarkTime;
 				report["Collection Time"] = collectionTime;
 				report["Consumption Time"] = consumptionTime;
-				report["Collection Steps/Second"] = stepsCollected / collectionTime;
+				report["Collection Steps/Second"] = collected.stepsCollected / collectionTime; // Local collection only
 				report["Consumption Steps/Second"] = stepsCollected / consumptionTime;
-				report["Overall Steps/Second"] = stepsCollected / (collectionTime + consumptionTime);
+				if (pipelined) {
+					// Collection and consumption overlap, so use the real time this iteration took
+					report["Overall Steps/Second"] = stepsCollected / iterationTimer.Elapsed();
+				} else {
+					report["Overall Steps/Second"] = stepsCollected / (collectionTime + consumptionTime);
+				}
 
 				uint64_t prevTimesteps = totalTimesteps;
 				totalTimesteps += stepsCollected;
@@ -848,12 +1616,21 @@ void GGL::Learner::Start() {
 				totalIterations++;
 				report["Total Iterations"] = totalIterations;
 
+				if (rolloutServer)
+					rolloutServer->BroadcastPolicy(fnMakeRolloutPolicy());
+
 				if (versionMgr)
 					versionMgr->OnIteration(ppo, report, totalTimesteps, prevTimesteps);
 
 				if (saveQueued) {
+					// Let the collector finish before we save and exit
+					if (pendingCollection.valid())
+						pendingCollection.wait();
+
 					if (!config.checkpointFolder.empty())
 						Save();
+					if (checkpointWriter)
+						checkpointWriter->WaitUntilIdle();
 					exit(0);
 				}
 
@@ -889,11 +1666,20 @@ void GGL::Learner::Start() {
 						"-Env Step Time",
 						"Consumption Time",
 						"-GAE Time",
-						"-PPO Learn Time"
+						"-PPO Learn Time",
+						"-Collection Wait Time",
 						"",
 						"Collected Timesteps",
+						"-Workers/Collected Timesteps",
+						"-Workers/Avg Policy Lag",
 						"Total Timesteps",
-						"Total Iterations"
+						"Total Iterations",
+						"",
+						"Memory/Process",
+						"-Memory/Arenas",
+						"-Memory/Rollout Storage",
+						"-Memory/Old Versions",
+						"Memory/Torch CUDA Reserved"
 					}
 				);
 			}
@@ -905,9 +1691,23 @@ void GGL::Learner::Start() {
 }
 
 GGL::Learner::~Learner() {
+	if (obsStandardizer) {
+		envSet->obsStandardizer = NULL;
+		delete obsStandardizer;
+	}
+
+#ifdef RG_CUDA_SUPPORT
+	if (envStateMemPinned) {
+		cudaHostUnregister(envSet->state.obs.data.data());
+		cudaHostUnregister(envSet->state.actionMasks.data.data());
+	}
+#endif
 	delete ppo;
 	delete versionMgr;
 	delete metricSender;
 	delete renderSender;
+	delete rolloutServer;
+	delete rolloutClient;
+	delete checkpointWriter; // Finishes any queued saves
 	pybind11::finalize_interpreter();
 }
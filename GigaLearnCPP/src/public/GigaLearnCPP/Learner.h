@@ -9,6 +9,7 @@
 namespace GGL {
 
 	typedef std::function<void(class Learner*, const std::vector<RLGC::GameState>& states, Report& report)> StepCallbackFn;
+	typedef std::function<void(class Learner*, int arenaIdx, const RLGC::GameState& state, Report& report)> ArenaStepCallbackFn;
 
 	// https://github.com/AechPro/rlgym-ppo/blob/main/rlgym_ppo/learner.py
 	class RG_IMEXPORT Learner {
@@ -29,6 +30,18 @@ namespace GGL {
 
 		struct WelfordStat* returnStat;
 		struct BatchedWelfordStat* obsStat;
+		std::mutex obsStatMutex; // Guards obsStat when collection is pipelined
+		RLGC::ObsStandardizer* obsStandardizer; // Applies obsStat inside the env step jobs
+
+		class RolloutServer* rolloutServer; // Only exists if config.rolloutServerPort is set
+		class RolloutClient* rolloutClient = NULL; // Only exists if this is a rollout worker
+
+		class CheckpointWriter* checkpointWriter; // Only exists if config.asyncSaving is set
+
+		bool envStateMemPinned = false; // If the env obs/mask buffers are page-locked for faster GPU uploads
+
+		// Process memory used per arena (including its RocketSim/Bullet allocations), measured when the envs are first created
+		double envMemoryPerArena = 0;
 
 		std::string runID = {};
 
@@ -36,11 +49,23 @@ namespace GGL {
 			totalTimesteps = 0,
 			totalIterations = 0;
 
+		// NOTE: If collection is pipelined (config.collectionPolicyLag > 0), this is called from the collection thread
 		StepCallbackFn stepCallback = NULL;
 
+		// Called for each arena after it steps, from inside the env step jobs, so metrics can be computed in parallel
+		// Must be safe to run concurrently for different arenas
+		// Each arena has its own report, which is merged into the iteration's report at the end of collection
+		ArenaStepCallbackFn arenaStepCallback = NULL;
+		std::vector<Report> arenaReports;
+
 		Learner(RLGC::EnvCreateFn envCreateFunc, LearnerConfig config, StepCallbackFn stepCallback = NULL);
 		void Start();
 
+		// Runs as a rollout worker for a learner started with config.rolloutServerPort
+		// Collects experience with the latest policy from the learner and sends it back, nothing is learned here
+		// The worker should be created with the same env and config as the learner, though usually on the CPU device and with no checkpoint folder
+		void StartRolloutWorker(const std::string& host, int port);
+
 		void StartTransferLearn(const TransferLearnConfig& transferLearnConfig);
 
 		void StartQuitKeyThread(bool& quitPressed, std::thread& outThread);
@@ -48,6 +73,13 @@ namespace GGL {
 		void Save();
 		void Load();
 		void SaveStats(std::filesystem::path path);
+		std::string SerializeStats();
+		void DeserializeStats(const std::string& jsonStr);
+
+		// Rewrites every checkpoint and saved policy version in config.checkpointFolder as a packed checkpoint, and enables config.packedCheckpoints
+		// Checkpoints must match the current model arch, call this before Start()
+		void ConvertCheckpointsToPacked();
+		void UpdateObsStandardizer(); // Merges newly accumulated obs samples and updates the standardizer's stats
 		void LoadStats(std::filesystem::path path);
 
 		RG_NO_COPY(Learner);
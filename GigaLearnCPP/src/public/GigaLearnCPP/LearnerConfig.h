@@ -6,6 +6,7 @@
 #include <RLGymCPP/BasicTypes/Lists.h>
 #include "PPO/PPOLearnerConfig.h"
 #include "SkillTrackerConfig.h"
+#include "AutotuneConfig.h"
 
 namespace MyGL {
 	struct Scenario;
@@ -25,6 +26,11 @@ namespace GGL {
 		int tickSkip = 8;
 		int actionDelay = 7;
 
+		// Arenas are split into this many shards during collection
+		// Each shard starts stepping as soon as its actions are inferred, so env stepping overlaps with inferring the other shards
+		// Mainly useful on CPU, where inference and env stepping compete for the same cores
+		int numEnvShards = 1;
+
 		bool renderMode = false;
 		// If renderMode, this is the scaling of time for the game
 		// 1.0 = Run the game at real time
@@ -33,6 +39,36 @@ namespace GGL {
 
 		PPOLearnerConfig ppo = {};
 
+		// How many iterations behind the learner the collection policy is allowed to be (0 or 1)
+		// 0 = Collect, then learn (fully on-policy)
+		// 1 = Collect the next iteration in the background while learning from the current one
+		//	The step callback will then be called from the collection thread
+		int collectionPolicyLag = 0;
+
+		// Infer critic values in the same forward as the actions during collection, rather than in a separate pass over every collected state
+		// Only the next states of truncated episodes then need an extra critic pass
+		// If collection is pipelined, the values will come from the collection snapshot of the critic
+		bool collectCriticValues = false;
+
+		// Run GAE for each episode on the thread pool as soon as it finishes, rather than over all experience after collection
+		// Requires collectCriticValues, and isn't used for iterations that include experience from rollout workers
+		bool streamGAE = false;
+
+		// Also learn from the X-mirrored version of every collected step (mirrored obs and action, same reward and terminal)
+		// Every simulated step then gives two samples, so tsPerItr is reached in half the env steps
+		// Timestep counts, steps/second metrics, tsPerSave and tsPerVersion still count env steps
+		// Requires an action parser that supports GetMirrorMap(), and an obs builder that works with mirrored states (see RLGC::MirrorStateX())
+		bool mirrorAugment = false;
+
+		// If non-zero, the learner listens on this port for rollout workers (see Learner::StartRolloutWorker())
+		// Experience from workers is learned from alongside the local experience
+		int rolloutServerPort = 0;
+		// Address the rollout server listens on, loopback by default since the protocol has no authentication
+		// Set to the address of a trusted network interface (or empty for all interfaces) to accept workers from other machines
+		std::string rolloutServerBindAddress = "127.0.0.1";
+		// Worker experience collected with a policy more than this many iterations old is discarded
+		int maxRolloutPolicyLag = 3;
+
 		// Checkpoints are saved here as timestep-numbered subfolders
 		//	e.g. a checkpoint at 20,000 steps will save to a subfolder called "20000"
 		// Set empty to disable saving
@@ -44,13 +80,17 @@ namespace GGL {
 
 		int64_t randomSeed = -1; // Set to -1 to use the current time
 		int checkpointsToKeep = 8; // Checkpoint storage limit before old checkpoints are deleted, set to -1 to disable
+		bool asyncSaving = true; // Copy checkpoints into memory and write them to disk on a background thread, so training doesn't wait on the disk
+		// Save each checkpoint (and policy version) as a single memory-mappable file, which loads much faster
+		// Either format can always be loaded, use Learner::ConvertCheckpointsToPacked() to convert existing checkpoints
+		bool packedCheckpoints = false;
 		LearnerDeviceType deviceType = LearnerDeviceType::AUTO; // Auto will use your CUDA GPU if available
 
 		// Standardize the obs values (doesn't seem to help much from my testing)
 		bool standardizeObs = false;
 		float minObsSTD = 1 / 10.f;
 		float maxObsMeanRange = 3;
-		int maxObsSamples = 100;
+		int maxObsSamples = 100; // Unused, every obs is now sampled inside the env step jobs
 
 		// Standardize the returns to help the critic (don't disable this unless you know what you're doing)
 		bool standardizeReturns = true;
@@ -58,6 +98,7 @@ namespace GGL {
 
 		// Will automatically add the rewards to metrics
 		bool addRewardsToMetrics = true;
+		// Reward metrics are cheap to add, so these can be raised (up to numGames and 1) for less noisy reward metrics
 		int maxRewardSamples = 50; // Maximum reward samples per step for reward metrics
 		int rewardSampleRandInterval = 8; // Randomized interval range between sampling rewards (per step)
 		int scenarioRewardLogInterval = 512; // Steps between logging scenario-specific reward averages
@@ -74,11 +115,26 @@ namespace GGL {
 		int maxOldVersions = 32;
 
 		bool trainAgainstOldVersions = false;
-		float trainAgainstOldChance = 0.15f; // Chance (from 0 - 1) that an iteration will train against an old version
+		// Chance (from 0 - 1) that an arena will have one team controlled by a random old version
+		// This is re-rolled for each arena whenever its episode ends
+		float trainAgainstOldChance = 0.15f;
+
+		// On the first iteration after starting (and loading), also learn from the collected experience in fp32 and with ppo.mixedPrecisionLearn,
+		// then restore the models, so the real update is unaffected
+		// Adds the consumption steps/second of each precision (and how closely their updates match) to that iteration's metrics
+		// The setting itself is left as-is, compare the rewards of a run with each setting to judge learning quality
+		bool benchmarkMixedPrecision = false;
 
 		SkillTrackerConfig skillTracker = {};
+		AutotuneConfig autotune = {};
 		std::function<std::optional<MyGL::Scenario>(int index)> scenarioProvider;
 
 		std::filesystem::path loadPretrainedModelPath = {};
+
+		// Record a Chrome/Perfetto trace of the training loop, env jobs and PPO minibatches for some iterations
+		// Open the output in ui.perfetto.dev or chrome://tracing
+		int traceStartIteration = -1; // Iteration (counted from when Start() is called) to start tracing at, set to -1 to disable
+		int traceIterations = 1; // Number of iterations to trace
+		std::filesystem::path traceOutputPath = "trace.json";
 	};
 }
@@ -12,6 +12,12 @@ namespace GGL {
 		int64_t batchSize = 50'000;
 		int64_t miniBatchSize = 0; // Set to 0 to just use batchSize
 
+		// On CPU, split each batch into minibatches that are learned from on this many threads at once, each with its own copy of the models
+		// The gradients are summed before each optimizer step, so the result is the same as learning from the whole batch
+		// Minibatches are at most miniBatchSize (if set), which also limits the memory used by activations
+		// Torch's own thread count (see torch::set_num_threads()) should be lowered to about (cores / cpuLearnThreads)
+		int cpuLearnThreads = 1;
+
 		// On the last batch of the iteration, 
 		//	if the amount of remaining experience exceeds the batch size, 
 		//	all remaining experience is used as a larger batch.
@@ -19,6 +25,10 @@ namespace GGL {
 		// This will only happen if the amount of remaining experience is < batchSize*2.
 		bool overbatching = true;
 
+		// Gather each batch from the experience when it is needed, instead of shuffling all of it into one buffer every epoch
+		// Uses less memory (no second copy of the experience), but is slower
+		bool lazyBatches = false;
+
 		double maxEpisodeDuration = 120; // In seconds
 
 		// Actions with the highest probability are always chosen, instead of being more likely
@@ -30,6 +40,12 @@ namespace GGL {
 		// This is much faster on GPU, not so much for CPU
 		bool useHalfPrecision = false;
 
+		// Run the learning forward/backward passes under bf16 autocast (on CPU or GPU)
+		// Parameters, gradients, optimizer states and losses all stay fp32, only the layers' matmuls are done in bf16
+		// This is much faster on CPUs with bf16 matmul support (AVX512-BF16/AMX), and slower on ones without
+		// See LearnerConfig::benchmarkMixedPrecision to measure it
+		bool mixedPrecisionLearn = false;
+
 		PartialModelConfig policy, critic, sharedHead;
 
 		int epochs = 2;
@@ -0,0 +1,42 @@
+#include "MetricRegistry.h"
+
+#include <mutex>
+
+struct MetricInfo {
+	std::string name;
+	bool reportMinMax;
+};
+
+static std::mutex g_MetricsMutex = {};
+static std::vector<MetricInfo> g_Metrics = {};
+static std::unordered_map<std::string, GGL::MetricID> g_MetricIDs = {};
+
+GGL::MetricID GGL::MetricRegistry::Register(const std::string& name, bool reportMinMax) {
+	std::lock_guard<std::mutex> lock(g_MetricsMutex);
+
+	auto itr = g_MetricIDs.find(name);
+	if (itr != g_MetricIDs.end()) {
+		g_Metrics[itr->second].reportMinMax |= reportMinMax;
+		return itr->second;
+	}
+
+	MetricID id = g_Metrics.size();
+	g_Metrics.push_back({ name, reportMinMax });
+	g_MetricIDs[name] = id;
+	return id;
+}
+
+std::string GGL::MetricRegistry::GetName(MetricID id) {
+	std::lock_guard<std::mutex> lock(g_MetricsMutex);
+	return g_Metrics.at(id).name;
+}
+
+bool GGL::MetricRegistry::GetReportMinMax(MetricID id) {
+	std::lock_guard<std::mutex> lock(g_MetricsMutex);
+	return g_Metrics.at(id).reportMinMax;
+}
+
+int GGL::MetricRegistry::GetCount() {
+	std::lock_guard<std::mutex> lock(g_MetricsMutex);
+	return g_Metrics.size();
+}
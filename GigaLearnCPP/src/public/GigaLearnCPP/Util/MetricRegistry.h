@@ -0,0 +1,20 @@
+#pragma once
+#include "../Framework.h"
+
+namespace GGL {
+	typedef int MetricID;
+
+	// Interns metric names to small integer IDs, so hot paths can add to a report's fixed metric slots (see Report::AddStat())
+	//	without building or hashing a string every time
+	// IDs are shared by every report, and are never removed
+	struct RG_IMEXPORT MetricRegistry {
+		// Returns the existing ID if the name is already registered
+		// If reportMinMax, the min and max are also reported alongside the average
+		// NOTE: Takes a lock, so register once and keep the ID (e.g. in a static local) rather than calling this every step
+		static MetricID Register(const std::string& name, bool reportMinMax = false);
+
+		static std::string GetName(MetricID id);
+		static bool GetReportMinMax(MetricID id);
+		static int GetCount();
+	};
+}
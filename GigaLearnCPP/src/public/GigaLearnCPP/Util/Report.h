@@ -2,6 +2,7 @@
 #include "../Framework.h"
 
 #include "Utils.h"
+#include "MetricRegistry.h"
 
 namespace GGL {
 	struct Report {
@@ -15,6 +16,39 @@ namespace GGL {
 		};
 
 		std::unordered_map<std::string, Avg> avgs;
+
+		// Accumulated values of interned metrics, indexed by ID
+		// Adding to these is just a few arithmetic ops, Finish() turns them into averages in data
+		struct Stat {
+			Val sum = 0, min = 0, max = 0;
+			uint64_t count = 0;
+
+			void Add(Val val) {
+				if (count == 0) {
+					min = max = val;
+				} else {
+					min = RS_MIN(min, val);
+					max = RS_MAX(max, val);
+				}
+				sum += val;
+				count++;
+			}
+
+			void Merge(const Stat& other) {
+				if (other.count == 0)
+					return;
+
+				if (count == 0) {
+					*this = other;
+				} else {
+					sum += other.sum;
+					min = RS_MIN(min, other.min);
+					max = RS_MAX(max, other.max);
+					count += other.count;
+				}
+			}
+		};
+		std::vector<Stat> stats;
 		
 		Report() = default;
 
@@ -44,6 +78,14 @@ namespace GGL {
 			avg.count++;
 		}
 
+		// Like AddAvg(), but without any string hashing or allocation
+		// Reports are not thread-safe, so give each thread its own report and Merge() them
+		void AddStat(MetricID id, Val val) {
+			if (id >= stats.size())
+				stats.resize(id + 1);
+			stats[id].Add(val);
+		}
+
 		void FinishAvg(const std::string& key) {
 			auto itr = avgs.find(key);
 			if (itr == avgs.end())
@@ -71,6 +113,20 @@ namespace GGL {
 			for (auto& pair : avgs)
 				data[pair.first] = pair.second.total / (Val)pair.second.count;
 			avgs.clear();
+
+			for (MetricID id = 0; id < stats.size(); id++) {
+				auto& stat = stats[id];
+				if (stat.count == 0)
+					continue;
+
+				std::string name = MetricRegistry::GetName(id);
+				data[name] = stat.sum / (Val)stat.count;
+				if (MetricRegistry::GetReportMinMax(id)) {
+					data[name + " (Min)"] = stat.min;
+					data[name + " (Max)"] = stat.max;
+				}
+			}
+			stats.clear();
 		}
 
 		void Clear() {
@@ -96,6 +152,24 @@ namespace GGL {
 			return *this;
 		}
 
+		// Combines another report into this one
+		// Unlike operator+, values with the same key are summed, and unfinished averages are combined
+		void Merge(const Report& other) {
+			for (auto& pair : other.data)
+				Add(pair.first, pair.second);
+
+			for (auto& pair : other.avgs) {
+				auto& avg = avgs[pair.first];
+				avg.total += pair.second.total;
+				avg.count += pair.second.count;
+			}
+
+			if (other.stats.size() > stats.size())
+				stats.resize(other.stats.size());
+			for (int i = 0; i < other.stats.size(); i++)
+				stats[i].Merge(other.stats[i]);
+		}
+
 		void Display(std::vector<std::string> keyRows) const;
 	};
 }
\ No newline at end of file
@@ -1,5 +1,14 @@
 #include "Utils.h"
 
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <unistd.h>
+#endif
+
 std::set<int64_t> GGL::Utils::FindNumberedDirs(std::filesystem::path basePath) {
 	std::set<int64_t> results = {};
 
@@ -24,4 +33,34 @@ std::set<int64_t> GGL::Utils::FindNumberedDirs(std::filesystem::path basePath) {
 	}
 
 	return results;
-}
\ No newline at end of file
+}
+
+std::string GGL::Utils::GetHostName() {
+#ifdef _WIN32
+	char name[MAX_COMPUTERNAME_LENGTH + 1] = {};
+	DWORD size = sizeof(name);
+	if (GetComputerNameA(name, &size))
+		return name;
+#else
+	char name[256] = {};
+	if (gethostname(name, sizeof(name) - 1) == 0)
+		return name;
+#endif
+	return "unknown";
+}
+
+uint64_t GGL::Utils::GetProcessMemoryUsage() {
+#ifdef _WIN32
+	PROCESS_MEMORY_COUNTERS counters = {};
+	if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+		return counters.WorkingSetSize;
+	return 0;
+#else
+	// Second value is the resident page count
+	std::ifstream fIn("/proc/self/statm");
+	uint64_t totalPages, residentPages;
+	if (fIn >> totalPages >> residentPages)
+		return residentPages * sysconf(_SC_PAGESIZE);
+	return 0;
+#endif
+}
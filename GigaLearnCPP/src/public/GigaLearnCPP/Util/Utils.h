@@ -26,6 +26,11 @@ namespace GGL {
 
 		std::set<int64_t> FindNumberedDirs(std::filesystem::path basePath);
 
+		std::string GetHostName();
+
+		// Resident memory of this process in bytes, or 0 if it can't be read
+		uint64_t GetProcessMemoryUsage();
+
 		template <typename T>
 		std::string NumToStr(T val) {
 			// https://stackoverflow.com/a/7277333
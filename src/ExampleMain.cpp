@@ -166,33 +166,39 @@ void StepCallback(Learner* learner, const std::vector<GameState>& states, Report
             }
         }
     }
+}
 
-    // To prevent expensive metrics from eating at performance, we will only run them on 1/4th of steps
-    // This doesn't really matter unless you have expensive metrics (which this example doesn't)
-    bool doExpensiveMetrics = (rand() % 4) == 0;
-
-    // Add our metrics
-    for (auto& state : states) {
-        if (doExpensiveMetrics) {
-            for (auto& player : state.players) {
-                report.AddAvg("Player/In Air Ratio", !player.isOnGround);
-                report.AddAvg("Player/Ball Touch Ratio", player.ballTouchedStep);
-                report.AddAvg("Player/Demoed Ratio", player.isDemoed);
-
-                report.AddAvg("Player/Speed", player.vel.Length());
-                Vec dirToBall = (state.ball.pos - player.pos).Normalized();
-                report.AddAvg("Player/Speed Towards Ball", RS_MAX(0, player.vel.Dot(dirToBall)));
-
-                report.AddAvg("Player/Boost", player.boost);
-
-                if (player.ballTouchedStep)
-                    report.AddAvg("Player/Touch Height", state.ball.pos.z);
-            }
-        }
-
-        if (state.goalScored)
-            report.AddAvg("Game/Goal Speed", state.ball.vel.Length());
+// Runs inside the env step jobs, so per-player metrics are computed in parallel across arenas
+// Each arena has its own report, so there's no need to throttle these
+// Metric names are interned once, so adding them every step doesn't build or hash any strings
+void ArenaStepCallback(Learner* learner, int arenaIdx, const GameState& state, Report& report) {
+    static const MetricID
+        IN_AIR_RATIO = MetricRegistry::Register("Player/In Air Ratio"),
+        BALL_TOUCH_RATIO = MetricRegistry::Register("Player/Ball Touch Ratio"),
+        DEMOED_RATIO = MetricRegistry::Register("Player/Demoed Ratio"),
+        SPEED = MetricRegistry::Register("Player/Speed", true),
+        SPEED_TOWARDS_BALL = MetricRegistry::Register("Player/Speed Towards Ball"),
+        BOOST = MetricRegistry::Register("Player/Boost"),
+        TOUCH_HEIGHT = MetricRegistry::Register("Player/Touch Height", true),
+        GOAL_SPEED = MetricRegistry::Register("Game/Goal Speed", true);
+
+    for (auto& player : state.players) {
+        report.AddStat(IN_AIR_RATIO, !player.isOnGround);
+        report.AddStat(BALL_TOUCH_RATIO, player.ballTouchedStep);
+        report.AddStat(DEMOED_RATIO, player.isDemoed);
+
+        report.AddStat(SPEED, player.vel.Length());
+        Vec dirToBall = (state.ball.pos - player.pos).Normalized();
+        report.AddStat(SPEED_TOWARDS_BALL, RS_MAX(0, player.vel.Dot(dirToBall)));
+
+        report.AddStat(BOOST, player.boost);
+
+        if (player.ballTouchedStep)
+            report.AddStat(TOUCH_HEIGHT, state.ball.pos.z);
     }
+
+    if (state.goalScored)
+        report.AddStat(GOAL_SPEED, state.ball.vel.Length());
 }
 
 int main(int argc, char* argv[]) {
@@ -310,6 +316,7 @@ int main(int argc, char* argv[]) {
 
     // Make the learner with the environment creation function and the config we just made
     Learner* learner = new Learner(EnvCreateFunc, cfg, StepCallback);
+    learner->arenaStepCallback = ArenaStepCallback;
 
     // Start learning!
     learner->Start();